@@ -0,0 +1,329 @@
+/*
+  sfs_linux.c - Linux Hosted Port
+
+  Runs an SFS instance as a Linux process without a timer thread.
+    - gFreeRunCounter counts the ticks of CLOCK_MONOTONIC since the
+      port started, caught up on every poll, so it does not drift with
+      the time spent in tasks.  _di/_ei of the FRC are a mutex, so
+      other threads may read the counter too.
+    - Tasks register file descriptors and wait on them with
+      SFS_linuxWait(): one bit of an SFS_flags word per descriptor, so
+      a task waiting for a socket is off the queues instead of polling
+      it every pass.
+    - When no task is ready the idle hook blocks in epoll_wait() until
+      a descriptor is ready or a timed task is due.  The timerfd is a
+      one-shot armed for that tick, and left disarmed when nothing is
+      timed, so an idle process is not woken at all.
+  This module is hosted only (Linux: timerfd, epoll, pthread).  One
+  port per process, as there is one gFreeRunCounter.
+*/
+#define _POSIX_C_SOURCE 200112L
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include "frcc.h"
+#include "sfs_linux.h"
+
+#define LINUX_NULL ((void *)0)
+/* epoll data of the timerfd, past the descriptor slots */
+#define LINUX_TIMER SFS_LINUX_FDS
+
+static SFS_linux *linux_active = LINUX_NULL;
+static pthread_mutex_t linux_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct timespec linux_origin;    /* tick 0 of the running port */
+
+static void linux_idle(unsigned long);
+static void linux_alarm(SFS_linux *,unsigned long);
+static void linux_catchUp(SFS_linux *);
+static short linux_arm(SFS_linux *,short,int);
+static void linux_di(void);
+static void linux_ei(void);
+
+short SFS_linuxInitialize(SFS_linux *,SFS_ctx *,unsigned long);
+void SFS_linuxShutdown(SFS_linux *);
+short SFS_linuxWatch(SFS_linux *,int,unsigned int);
+short SFS_linuxUnwatch(SFS_linux *,short);
+unsigned int SFS_linuxWait(SFS_linux *,short);
+unsigned int SFS_linuxPoll(SFS_linux *,int);
+short SFS_linuxDispatch(SFS_linux *);
+
+/* Counts a tick every `usec` microseconds and takes over the timer and
+   idle hooks of `ctx`.  Returns -1 if another port is running or a
+   descriptor cannot be created. */
+short SFS_linuxInitialize(SFS_linux *lx,SFS_ctx *ctx,unsigned long usec)
+{
+  struct epoll_event ev;
+  short i;
+
+  if(ctx==LINUX_NULL || usec==0 || linux_active!=LINUX_NULL)
+    return -1;
+
+  lx->timer = timerfd_create(CLOCK_MONOTONIC,TFD_NONBLOCK|TFD_CLOEXEC);
+  lx->poll = epoll_create1(EPOLL_CLOEXEC);
+  ev.events = EPOLLIN;
+  ev.data.u32 = LINUX_TIMER;
+  if(lx->timer<0 || lx->poll<0 ||
+     epoll_ctl(lx->poll,EPOLL_CTL_ADD,lx->timer,&ev)<0){
+    if(lx->timer>=0)
+      close(lx->timer);
+    if(lx->poll>=0)
+      close(lx->poll);
+    return -1;
+  }
+
+  lx->ctx = ctx;
+  for(i=0;i<SFS_LINUX_FDS;i++)
+    lx->fd[i].fd = -1;
+  SFS_flagsInit(&lx->ready,0);
+  lx->idled = 0;
+  lx->usec = usec;
+  lx->ticks = 0;
+  lx->waits = 0;
+  lx->blocks = 0;
+  clock_gettime(CLOCK_MONOTONIC,&linux_origin);
+  linux_active = lx;
+
+  FRCInterrupt(linux_di,linux_ei);
+  SFS_ctxTimer(ctx,GetFreeRunCounter);
+  SFS_ctxIdle(ctx,linux_idle);
+
+  return 0;
+}
+
+/* Closes the timer and epoll descriptors; watched ones stay open.
+   gFreeRunCounter stops, so timed tasks no longer wake up. */
+void SFS_linuxShutdown(SFS_linux *lx)
+{
+  if(linux_active!=lx)
+    return;
+
+  SFS_ctxIdle(lx->ctx,(void (*)(unsigned long))0);
+  close(lx->poll);
+  close(lx->timer);
+  linux_active = LINUX_NULL;
+}
+
+/* Watches `fd` for SFS_LINUX_READ and/or SFS_LINUX_WRITE.  Returns the
+   slot for SFS_linuxWait(), or -1 if the port is full or epoll
+   refuses the descriptor. */
+short SFS_linuxWatch(SFS_linux *lx,int fd,unsigned int events)
+{
+  SFS_linuxFd *w;
+  short id;
+
+  events &= SFS_LINUX_READ|SFS_LINUX_WRITE;
+  if(fd<0 || events==0)
+    return -1;
+  for(id=0;id<SFS_LINUX_FDS && lx->fd[id].fd>=0;id++)
+    ;
+  if(id==SFS_LINUX_FDS)
+    return -1;
+
+  w = &lx->fd[id];
+  w->fd = fd;
+  w->events = events;
+  w->got = 0;
+  w->armed = 0;
+  w->wakes = 0;
+  if(linux_arm(lx,id,EPOLL_CTL_ADD)<0){
+    w->fd = -1;
+    return -1;
+  }
+  SFS_clearFlags(&lx->ready,1UL << id);
+
+  return id;
+}
+
+/* Stops watching a slot.  A task still waiting on it is not woken;
+   kill it first or leave it waiting. */
+short SFS_linuxUnwatch(SFS_linux *lx,short id)
+{
+  if(id<0 || id>=SFS_LINUX_FDS || lx->fd[id].fd<0)
+    return -1;
+
+  epoll_ctl(lx->poll,EPOLL_CTL_DEL,lx->fd[id].fd,LINUX_NULL);
+  lx->fd[id].fd = -1;
+  SFS_clearFlags(&lx->ready,1UL << id);
+
+  return 0;
+}
+
+/* For the running task: the readiness of slot `id` reported since its
+   last call, which it now owns.  Otherwise 0, and the task is not
+   dispatched again until the descriptor is ready.  Each report is
+   given once; the descriptor is watched again on the next wait, and
+   if it is still ready then it is reported again at once. */
+unsigned int SFS_linuxWait(SFS_linux *lx,short id)
+{
+  SFS_linuxFd *w;
+  unsigned long bit;
+  unsigned int got;
+
+  if(id<0 || id>=SFS_LINUX_FDS || lx->fd[id].fd<0)
+    return 0;
+
+  w = &lx->fd[id];
+  bit = 1UL << id;
+  if(!SFS_ctxWaitAny(lx->ctx,&lx->ready,bit)){
+    if(!w->armed)
+      linux_arm(lx,id,EPOLL_CTL_MOD);
+    return 0;
+  }
+  SFS_clearFlags(&lx->ready,bit);
+  got = w->got;
+  w->got = 0;
+
+  return got;
+}
+
+/* One epoll_wait() of up to `ms` milliseconds (-1: no limit).  Brings
+   gFreeRunCounter up to the clock and makes the tasks of the ready
+   descriptors ready.  Returns the descriptors reported. */
+unsigned int SFS_linuxPoll(SFS_linux *lx,int ms)
+{
+  struct epoll_event ev[SFS_LINUX_FDS + 1];
+  SFS_linuxFd *w;
+  uint64_t exp;
+  unsigned int got,cnt = 0;
+  int i,n;
+
+  lx->waits++;
+  if(ms!=0)
+    lx->blocks++;
+  n = epoll_wait(lx->poll,ev,SFS_LINUX_FDS + 1,ms);
+  linux_catchUp(lx);
+  for(i=0;i<n;i++){
+    if(ev[i].data.u32==LINUX_TIMER){
+      if(read(lx->timer,&exp,sizeof(exp))<0)
+        exp = 0;              /* the read only clears the expiration */
+      continue;
+    }
+    w = &lx->fd[ev[i].data.u32];
+    if(w->fd<0)
+      continue;
+    got = 0;
+    if(ev[i].events & EPOLLIN)
+      got |= SFS_LINUX_READ;
+    if(ev[i].events & EPOLLOUT)
+      got |= SFS_LINUX_WRITE;
+    if(ev[i].events & (EPOLLERR|EPOLLHUP))
+      got |= w->events;       /* the task finds out by reading/writing */
+    w->got |= got & w->events;
+    w->armed = 0;
+    w->wakes++;
+    cnt++;
+    SFS_ctxSetFlags(lx->ctx,&lx->ready,1UL << ev[i].data.u32);
+  }
+
+  return cnt;
+}
+
+/* One dispatch pass.  When tasks were ready the idle hook did not
+   run, so the descriptors and the timer are looked at after the pass
+   without blocking. */
+short SFS_linuxDispatch(SFS_linux *lx)
+{
+  short ret;
+
+  lx->idled = 0;
+  ret = SFS_ctxDispatch(lx->ctx);
+  if(!lx->idled)
+    SFS_linuxPoll(lx,0);
+
+  return ret;
+}
+
+/*-------------------- static functions --------------------*/
+/* Nothing is ready: block until a descriptor is reported or `ticks`
+   have passed.  The one-shot timer only wakes epoll_wait() at that
+   tick; for SFS_FOREVER it is disarmed and only a descriptor wakes
+   the process.  A wakeup short of the tick stays in here. */
+static void linux_idle(unsigned long ticks)
+{
+  SFS_linux *lx = linux_active;
+  unsigned long start;
+
+  if(lx==LINUX_NULL)
+    return;
+
+  lx->idled = 1;
+  if(ticks==0){
+    SFS_linuxPoll(lx,0);
+    return;
+  }
+  linux_alarm(lx,ticks==SFS_FOREVER ? 0:lx->ticks + ticks);
+  start = lx->ticks;
+  while(SFS_linuxPoll(lx,-1)==0 && lx->ticks - start < ticks)
+    ;
+}
+
+/* Arms the timer, once, for the start of tick `tick`; 0 disarms it. */
+static void linux_alarm(SFS_linux *lx,unsigned long tick)
+{
+  struct itimerspec its;
+  uint64_t ns = (uint64_t)tick * lx->usec * 1000U;
+
+  its.it_interval.tv_sec = 0;
+  its.it_interval.tv_nsec = 0;
+  its.it_value.tv_sec = 0;
+  its.it_value.tv_nsec = 0;
+  if(tick){
+    ns += (uint64_t)linux_origin.tv_nsec;
+    its.it_value.tv_sec = linux_origin.tv_sec + (time_t)(ns / 1000000000U);
+    its.it_value.tv_nsec = (long)(ns % 1000000000U);
+  }
+  timerfd_settime(lx->timer,TFD_TIMER_ABSTIME,&its,LINUX_NULL);
+}
+
+/* Adds the ticks the clock has gone through since the last poll. */
+static void linux_catchUp(SFS_linux *lx)
+{
+  struct timespec now;
+  uint64_t us;
+  unsigned long ticks;
+
+  clock_gettime(CLOCK_MONOTONIC,&now);
+  us = (uint64_t)(now.tv_sec - linux_origin.tv_sec) * 1000000U;
+  us = us + (uint64_t)(now.tv_nsec / 1000) - (uint64_t)(linux_origin.tv_nsec / 1000);
+  ticks = (unsigned long)(us / lx->usec);
+  if(ticks==lx->ticks)
+    return;
+
+  linux_di();
+  gFreeRunCounter += ticks - lx->ticks;
+  linux_ei();
+  lx->ticks = ticks;
+}
+
+/* One-shot: a reported descriptor stays out of the set until its task
+   waits again, so one nobody waits on cannot keep epoll_wait() busy. */
+static short linux_arm(SFS_linux *lx,short id,int op)
+{
+  SFS_linuxFd *w = &lx->fd[id];
+  struct epoll_event ev;
+
+  ev.events = EPOLLONESHOT;
+  if(w->events & SFS_LINUX_READ)
+    ev.events |= EPOLLIN;
+  if(w->events & SFS_LINUX_WRITE)
+    ev.events |= EPOLLOUT;
+  ev.data.u32 = (uint32_t)id;
+  if(epoll_ctl(lx->poll,op,w->fd,&ev)<0)
+    return -1;
+  w->armed = 1;
+
+  return 0;
+}
+
+static void linux_di(void)
+{
+  pthread_mutex_lock(&linux_lock);
+}
+
+static void linux_ei(void)
+{
+  pthread_mutex_unlock(&linux_lock);
+}
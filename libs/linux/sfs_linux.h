@@ -0,0 +1,130 @@
+#ifndef __SFS_LINUX_INC__
+#define __SFS_LINUX_INC__
+
+#include "sfs.h"
+
+/*******************************
+[ function organization - PlantUML ]
+
+@startuml
+!theme plain
+skinparam packageStyle rectangle
+skinparam defaultFontName Arial
+skinparam defaultFontSize 9
+skinparam ranksep 120
+skinparam nodesep 80
+skinparam packagePadding 16
+
+title sfs_linux.c - Linux Hosted Port
+
+package "Public API" {
+  class SFS_linuxInitialize
+  class SFS_linuxShutdown
+  class SFS_linuxWatch
+  class SFS_linuxUnwatch
+  class SFS_linuxWait
+  class SFS_linuxPoll
+  class SFS_linuxDispatch
+}
+
+package "Static Functions" {
+  class linux_idle
+  class linux_di
+  class linux_ei
+}
+
+package "Linux" {
+  class timerfd
+  class epoll_wait
+}
+
+package "SFS instance API / FRC" {
+  class SFS_ctxTimer
+  class SFS_ctxIdle
+  class SFS_ctxDispatch
+  class SFS_ctxWaitAny
+  class SFS_ctxSetFlags
+  class FRCInterrupt
+  class gFreeRunCounter
+}
+
+SFS_linuxInitialize -down-> timerfd : created disarmed
+SFS_linuxInitialize -down-> FRCInterrupt : linux_di/linux_ei
+SFS_linuxInitialize -down-> SFS_ctxTimer : GetFreeRunCounter
+SFS_linuxInitialize -down-> SFS_ctxIdle : linux_idle
+SFS_linuxDispatch -down-> SFS_ctxDispatch : calls
+SFS_linuxDispatch -down-> SFS_linuxPoll : no idle this pass
+SFS_ctxDispatch -down-> linux_idle : nothing ready
+linux_idle -down-> timerfd : one-shot at the next due tick
+linux_idle -down-> SFS_linuxPoll : blocks
+SFS_linuxPoll -down-> epoll_wait : calls
+SFS_linuxPoll -down-> gFreeRunCounter : ticks since start
+SFS_linuxPoll -down-> SFS_ctxSetFlags : fd ready
+SFS_linuxWait -down-> SFS_ctxWaitAny : calls
+linux_di -down-> gFreeRunCounter : guards
+linux_ei -down-> gFreeRunCounter : guards
+
+@enduml
+*******************************/
+
+/* Watched descriptors per port: one bit each in an SFS_flags word. */
+#define SFS_LINUX_FDS 32
+/* Readiness reported by SFS_linuxWait(). */
+#define SFS_LINUX_READ 0x01U
+#define SFS_LINUX_WRITE 0x02U
+
+typedef struct SFS_linuxFd_tg {
+  int fd;                     /* -1: slot free */
+  unsigned int events;        /* SFS_LINUX_READ | SFS_LINUX_WRITE */
+  unsigned int got;           /* reported, not yet taken by the task */
+  short armed;                /* in the epoll set until reported */
+  unsigned long wakes;        /* readiness reports */
+} SFS_linuxFd;
+
+typedef struct SFS_linux_tg {
+  SFS_ctx *ctx;
+  int timer;                  /* timerfd, armed only while idle */
+  int poll;                   /* epoll instance */
+  SFS_linuxFd fd[SFS_LINUX_FDS];
+  SFS_flags ready;            /* one bit per slot with readiness */
+  short idled;                /* the idle hook polled this pass */
+  unsigned long usec;         /* tick period */
+  unsigned long ticks;        /* ticks since SFS_linuxInitialize() */
+  unsigned long waits;        /* epoll_wait() calls */
+  unsigned long blocks;       /* of which allowed to block */
+} SFS_linux;
+
+extern short SFS_linuxInitialize(SFS_linux *,SFS_ctx *,unsigned long);
+extern void SFS_linuxShutdown(SFS_linux *);
+extern short SFS_linuxWatch(SFS_linux *,int,unsigned int);
+extern short SFS_linuxUnwatch(SFS_linux *,short);
+extern unsigned int SFS_linuxWait(SFS_linux *,short);
+extern unsigned int SFS_linuxPoll(SFS_linux *,int);
+extern short SFS_linuxDispatch(SFS_linux *);
+
+/* [ Usage example ]
+
+static SFS_linux port;
+static short rx;
+
+void server(void)
+{
+  unsigned int got = SFS_linuxWait(&port,rx);
+  if(!got)
+    return;                       waits off the queues until readable
+  n = read(sock,buf,sizeof(buf));
+  ...
+}
+
+SFS_ctxInitialize(&ctx,pool,64);
+SFS_linuxInitialize(&port,&ctx,1000);   1 tick = 1000us
+rx = SFS_linuxWatch(&port,sock,SFS_LINUX_READ);
+SFS_ctxFork(&ctx,"SERVER",0,server);
+SFS_ctxForkPeriodic(&ctx,"BLINK",1,blink,500);
+while(1)
+  SFS_linuxDispatch(&port);       sleeps in epoll_wait while idle
+SFS_linuxShutdown(&port);
+
+*/
+
+#endif
@@ -0,0 +1,241 @@
+/*
+  sfs_pipe.c - Dataflow Pipeline
+
+  Runs a graph of SFS tasks (stages) joined by FIFO_cb or ring_buffer_t
+  channels (edges) on data availability.
+    - A stage may run once each of its inputs holds `take` items and
+      each of its outputs has room for `put`.  That is one bit of an
+      SFS_flags word per stage; a stage that may not run waits on its
+      bit with SFS_ctxWaitAny(), off the queues, instead of polling.
+    - After every activation only the edges of that stage are looked
+      at again, and with them the stages at their other ends.  Data
+      written by a stage reaches a consumer behind it in the same pass.
+    - Edges fed or drained by other code are looked at again by
+      SFS_pipeNotify().
+  Like the core, this module allocates nothing; the caller owns the
+  stage and edge arrays.
+*/
+#include "sfs_pipe.h"
+
+#define PIPE_NULL ((void *)0)
+
+static void pipe_run(void *);
+static short pipe_edge(SFS_pipe *,short,short,unsigned int,unsigned int,void *,short,unsigned int);
+static void pipe_check(SFS_pipe *,short);
+static unsigned int pipe_used(SFS_pipeEdge *);
+static unsigned int pipe_free(SFS_pipeEdge *);
+
+short SFS_pipeInitialize(SFS_pipe *,SFS_ctx *,SFS_pipeStage *,unsigned int,SFS_pipeEdge *,unsigned int);
+short SFS_pipeFork(SFS_pipe *,char *,short,void (*)(void *),void *);
+short SFS_pipeFifo(SFS_pipe *,short,unsigned int,short,unsigned int,struct FIFO_cb *);
+short SFS_pipeRing(SFS_pipe *,short,unsigned int,short,unsigned int,ring_buffer_t *,unsigned int);
+void SFS_pipeNotify(SFS_pipe *);
+short SFS_pipeStats(SFS_pipe *,unsigned int,SFS_pipeStat *);
+
+/* The stages run on `ctx`, which may hold other tasks too. */
+short SFS_pipeInitialize(SFS_pipe *pipe,SFS_ctx *ctx,SFS_pipeStage *stage,unsigned int stages,
+                         SFS_pipeEdge *edge,unsigned int edges)
+{
+  if(ctx==PIPE_NULL || stage==PIPE_NULL || edge==PIPE_NULL)
+    return -1;
+
+  pipe->ctx = ctx;
+  pipe->stage = stage;
+  pipe->stages = 0;
+  pipe->maxStages = stages < SFS_PIPE_STAGES ? stages:SFS_PIPE_STAGES;
+  pipe->edge = edge;
+  pipe->edges = 0;
+  pipe->maxEdges = edges;
+  SFS_flagsInit(&pipe->ready,0);
+
+  return 0;
+}
+
+/* Forks the task of a stage.  Returns its index for the edges, or -1
+   if the pipeline or the instance is full. */
+short SFS_pipeFork(SFS_pipe *pipe,char *name,short order,void (*func)(void *),void *arg)
+{
+  SFS_pipeStage *st;
+  short id = (short)pipe->stages;
+
+  if(pipe->stages>=pipe->maxStages)
+    return -1;
+
+  st = &pipe->stage[id];
+  st->pipe = pipe;
+  st->pFunction = func;
+  st->pArg = arg;
+  st->bit = 1UL << id;
+  st->runs = 0;
+  st->held = 0;
+  if(!SFS_ctxForkArg(pipe->ctx,name,order,pipe_run,st))
+    return -1;
+
+  pipe->stages++;
+  pipe_check(pipe,id);
+
+  return id;
+}
+
+/* Joins stage `from` to stage `to` through a FIFO.  Returns the index
+   of the edge, or -1. */
+short SFS_pipeFifo(SFS_pipe *pipe,short from,unsigned int put,short to,unsigned int take,struct FIFO_cb *fifo)
+{
+  return pipe_edge(pipe,from,to,put,take,fifo,SFS_PIPE_FIFO,1);
+}
+
+/* As SFS_pipeFifo, through a ring buffer of `item`-byte items. */
+short SFS_pipeRing(SFS_pipe *pipe,short from,unsigned int put,short to,unsigned int take,
+                   ring_buffer_t *ring,unsigned int item)
+{
+  if(item==0)
+    return -1;
+
+  return pipe_edge(pipe,from,to,put,take,ring,SFS_PIPE_RING,item);
+}
+
+/* Looks at every stage again, after other code wrote to or read from
+   an edge.  Call it from a task or between passes, not from an ISR. */
+void SFS_pipeNotify(SFS_pipe *pipe)
+{
+  short id;
+
+  for(id=0;id<(short)pipe->stages;id++)
+    pipe_check(pipe,id);
+}
+
+/* Copies the occupancy of edge `id`: items now, capacity and the
+   highest seen, and how often the edge held back its producer. */
+short SFS_pipeStats(SFS_pipe *pipe,unsigned int id,SFS_pipeStat *stat)
+{
+  SFS_pipeEdge *e;
+
+  if(id>=pipe->edges)
+    return -1;
+
+  e = &pipe->edge[id];
+  stat->used = pipe_used(e);
+  stat->capacity = stat->used + pipe_free(e);
+  stat->peak = e->peak;
+  stat->stalls = e->stalls;
+
+  return 0;
+}
+
+/*-------------------- static functions --------------------*/
+/* The task of every stage.  Not ready: wait for the bit, off the
+   queues.  Ready: one activation, then the stages it may have fed or
+   made room for. */
+static void pipe_run(void *arg)
+{
+  SFS_pipeStage *st = arg;
+  SFS_pipe *pipe = st->pipe;
+  SFS_pipeEdge *e;
+  short id = (short)(st - pipe->stage);
+  unsigned int i;
+
+  if(!SFS_ctxWaitAny(pipe->ctx,&pipe->ready,st->bit))
+    return;
+
+  (*st->pFunction)(st->pArg);
+  st->runs++;
+
+  pipe_check(pipe,id);
+  for(i=0;i<pipe->edges;i++){
+    e = &pipe->edge[i];
+    if(e->from==id && e->to!=SFS_PIPE_OUTSIDE)
+      pipe_check(pipe,e->to);
+    else if(e->to==id && e->from!=SFS_PIPE_OUTSIDE)
+      pipe_check(pipe,e->from);
+  }
+}
+
+static short pipe_edge(SFS_pipe *pipe,short from,short to,unsigned int put,unsigned int take,
+                       void *chan,short kind,unsigned int item)
+{
+  SFS_pipeEdge *e;
+
+  if(pipe->edges>=pipe->maxEdges || chan==PIPE_NULL || from==to ||
+     from>=(short)pipe->stages || to>=(short)pipe->stages ||
+     from<SFS_PIPE_OUTSIDE || to<SFS_PIPE_OUTSIDE)
+    return -1;
+
+  e = &pipe->edge[pipe->edges];
+  e->kind = kind;
+  e->pChan = chan;
+  e->item = item;
+  e->from = from;
+  e->to = to;
+  e->put = put;
+  e->take = take;
+  e->peak = pipe_used(e);
+  e->stalls = 0;
+  pipe->edges++;
+
+  if(from!=SFS_PIPE_OUTSIDE)
+    pipe_check(pipe,from);
+  if(to!=SFS_PIPE_OUTSIDE)
+    pipe_check(pipe,to);
+
+  return (short)(pipe->edges - 1);
+}
+
+/* Sets the bit of a stage whose inputs and outputs all allow an
+   activation, which makes it ready if it was waiting, and clears it
+   otherwise.  A stage with its inputs in hand but an output too full
+   counts one stall on that edge each time it gets held back. */
+static void pipe_check(SFS_pipe *pipe,short id)
+{
+  SFS_pipeStage *st = &pipe->stage[id];
+  SFS_pipeEdge *e;
+  SFS_pipeEdge *full = PIPE_NULL;
+  unsigned int i,used;
+  short starved = 0;
+
+  for(i=0;i<pipe->edges;i++){
+    e = &pipe->edge[i];
+    if(e->to==id){
+      used = pipe_used(e);
+      if(used > e->peak)
+        e->peak = used;
+      if(used < e->take)
+        starved = 1;
+    }else if(e->from==id){
+      used = pipe_used(e);
+      if(used > e->peak)
+        e->peak = used;
+      if(full==PIPE_NULL && pipe_free(e) < e->put)
+        full = e;
+    }
+  }
+
+  if(!starved && full==PIPE_NULL){
+    st->held = 0;
+    SFS_ctxSetFlags(pipe->ctx,&pipe->ready,st->bit);
+    return;
+  }
+  SFS_clearFlags(&pipe->ready,st->bit);
+  if(!starved && !st->held){
+    full->stalls++;
+    st->held = 1;
+  }
+}
+
+static unsigned int pipe_used(SFS_pipeEdge *e)
+{
+  if(e->kind==SFS_PIPE_RING)
+    return rb_get_used_space((ring_buffer_t *)e->pChan) / e->item;
+
+  return ((struct FIFO_cb *)e->pChan)->count;
+}
+
+static unsigned int pipe_free(SFS_pipeEdge *e)
+{
+  struct FIFO_cb *fifo;
+
+  if(e->kind==SFS_PIPE_RING)
+    return rb_get_free_space((ring_buffer_t *)e->pChan) / e->item;
+
+  fifo = e->pChan;
+  return fifo->capacity - fifo->count;
+}
@@ -0,0 +1,146 @@
+#ifndef __SFS_PIPE_INC__
+#define __SFS_PIPE_INC__
+
+#include "sfs.h"
+#include "fifo.h"
+#include "ring_buffer.h"
+
+/*******************************
+[ function organization - PlantUML ]
+
+@startuml
+!theme plain
+skinparam packageStyle rectangle
+skinparam defaultFontName Arial
+skinparam defaultFontSize 9
+skinparam ranksep 120
+skinparam nodesep 80
+skinparam packagePadding 16
+
+title sfs_pipe.c - Dataflow Pipeline
+
+package "Public API" {
+  class SFS_pipeInitialize
+  class SFS_pipeFork
+  class SFS_pipeFifo
+  class SFS_pipeRing
+  class SFS_pipeNotify
+  class SFS_pipeStats
+}
+
+package "Static Functions" {
+  class pipe_run
+  class pipe_edge
+  class pipe_check
+  class pipe_used
+  class pipe_free
+}
+
+package "SFS instance API" {
+  class SFS_ctxForkArg
+  class SFS_ctxWaitAny
+  class SFS_ctxSetFlags
+  class SFS_flagsInit
+  class SFS_clearFlags
+}
+
+SFS_pipeInitialize -down-> SFS_flagsInit : calls
+SFS_pipeFork -down-> SFS_ctxForkArg : one task per stage
+SFS_pipeFork -down-> pipe_check : calls
+SFS_pipeFifo -down-> pipe_edge : calls
+SFS_pipeRing -down-> pipe_edge : calls
+pipe_edge -down-> pipe_check : both ends
+SFS_pipeNotify -down-> pipe_check : every stage
+pipe_run -down-> SFS_ctxWaitAny : not ready: waits
+pipe_run -down-> pipe_check : neighbours
+pipe_check -down-> pipe_used : inputs
+pipe_check -down-> pipe_free : outputs
+pipe_check -down-> SFS_ctxSetFlags : ready
+pipe_check -down-> SFS_clearFlags : not ready
+
+@enduml
+*******************************/
+
+/* Stages per pipeline: one bit each in an SFS_flags word. */
+#define SFS_PIPE_STAGES 32
+/* Edge end outside the pipeline (fed or drained by other code). */
+#define SFS_PIPE_OUTSIDE (-1)
+#define SFS_PIPE_FIFO 0
+#define SFS_PIPE_RING 1
+
+/* A stage is an SFS task.  Its function moves the data itself, with
+   FIFO_pop()/rb_read() and FIFO_push()/rb_write(); the pipeline only
+   decides when it runs. */
+typedef struct SFS_pipeStage_tg {
+  struct SFS_pipe_tg *pipe;
+  void (*pFunction)(void *);
+  void *pArg;
+  unsigned long bit;          /* its bit in pipe->ready */
+  unsigned long runs;         /* activations */
+  short held;                 /* held back by a full output */
+} SFS_pipeStage;
+
+/* A channel between two stages.  An activation of `from` writes up
+   to `put` items, one of `to` reads `take` items. */
+typedef struct SFS_pipeEdge_tg {
+  short kind;                 /* SFS_PIPE_FIFO | SFS_PIPE_RING */
+  void *pChan;                /* struct FIFO_cb or ring_buffer_t */
+  unsigned int item;          /* bytes per item, rings only */
+  short from,to;              /* stage index or SFS_PIPE_OUTSIDE */
+  unsigned int put,take;
+  unsigned int peak;          /* highest occupancy seen, in items */
+  unsigned long stalls;       /* times it held back its producer */
+} SFS_pipeEdge;
+
+typedef struct SFS_pipe_tg {
+  SFS_ctx *ctx;
+  SFS_pipeStage *stage;
+  unsigned int stages,maxStages;
+  SFS_pipeEdge *edge;
+  unsigned int edges,maxEdges;
+  SFS_flags ready;            /* one bit per stage that may run */
+} SFS_pipe;
+
+/* Occupancy and backpressure of one edge, see SFS_pipeStats(). */
+typedef struct SFS_pipeStat_tg {
+  unsigned int used;
+  unsigned int capacity;
+  unsigned int peak;
+  unsigned long stalls;
+} SFS_pipeStat;
+
+extern short SFS_pipeInitialize(SFS_pipe *,SFS_ctx *,SFS_pipeStage *,unsigned int,SFS_pipeEdge *,unsigned int);
+extern short SFS_pipeFork(SFS_pipe *,char *,short,void (*)(void *),void *);
+extern short SFS_pipeFifo(SFS_pipe *,short,unsigned int,short,unsigned int,struct FIFO_cb *);
+extern short SFS_pipeRing(SFS_pipe *,short,unsigned int,short,unsigned int,ring_buffer_t *,unsigned int);
+extern void SFS_pipeNotify(SFS_pipe *);
+extern short SFS_pipeStats(SFS_pipe *,unsigned int,SFS_pipeStat *);
+
+/* [ Usage example ]
+
+static SFS_pipeStage stage[3];
+static SFS_pipeEdge edge[3];
+static SFS_pipe pipe;
+
+void filter(void *arg)            runs only with 8 samples in, room for 1 out
+{
+  short in[8],out;
+  for(i=0;i<8;i++)
+    FIFO_pop(&raw,&in[i]);
+  out = average(in);
+  FIFO_push(&smooth,&out);
+}
+
+SFS_pipeInitialize(&pipe,&ctx,stage,3,edge,3);
+a = SFS_pipeFork(&pipe,"FILTER",0,filter,0);
+b = SFS_pipeFork(&pipe,"LOG",1,logger,0);
+SFS_pipeFifo(&pipe,SFS_PIPE_OUTSIDE,1,a,8,&raw);
+SFS_pipeFifo(&pipe,a,1,b,1,&smooth);
+...
+FIFO_push(&raw,&sample);          from the ADC handler's task
+SFS_pipeNotify(&pipe);
+SFS_ctxDispatch(&ctx);
+
+*/
+
+#endif
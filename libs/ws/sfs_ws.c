@@ -0,0 +1,331 @@
+/*
+  sfs_ws.c - Work-Stealing Dispatcher
+
+  Spreads SFS tasks across a fixed set of pthread workers.
+    - Every worker owns an SFS_ctx; forks are spread round-robin and
+      `order` stays the priority inside each worker.
+    - A dispatch pass copies each worker's ready list into its deque.
+      The owner pops from the head (lowest order first) while idle
+      workers steal from the tail of busy ones.
+    - The calling thread acts as worker 0, so one worker means no
+      extra threads at all.
+  This module is hosted only (pthread, clock_gettime).
+*/
+#define _POSIX_C_SOURCE 200112L
+#include <time.h>
+#include "sfs_ws.h"
+
+#define WS_NULL ((void *)0)
+
+static pthread_key_t ws_key;
+static pthread_once_t ws_once = PTHREAD_ONCE_INIT;
+
+static void ws_keyCreate(void);
+static void *ws_thread(void *);
+static unsigned int ws_fill(SFS_ws *,SFS_wsWorker *);
+static void ws_run(SFS_wsWorker *);
+static struct SFS_tg *ws_pop(SFS_wsWorker *);
+static struct SFS_tg *ws_steal(SFS_wsWorker *);
+static void ws_giveup(void);
+static double ws_now(void);
+
+short SFS_wsInitialize(SFS_ws *,SFS_wsWorker *,unsigned int,struct SFS_tg *,struct SFS_tg **,SFS_align *,unsigned int);
+void SFS_wsShutdown(SFS_ws *);
+short SFS_wsFork(SFS_ws *,char *,unsigned short,void (*)(void));
+short SFS_wsForkArg(SFS_ws *,char *,unsigned short,void (*)(void *),void *);
+long SFS_wsDispatch(SFS_ws *);
+void *SFS_wsWork(void);
+void SFS_wsKill(void);
+short SFS_wsStats(SFS_ws *,unsigned int,SFS_wsStat *);
+
+short SFS_wsInitialize(SFS_ws *ws,SFS_wsWorker *worker,unsigned int workers,
+                       struct SFS_tg *pool,struct SFS_tg **slot,SFS_align *arena,unsigned int per)
+{
+  SFS_wsWorker *w;
+  unsigned int i,span;
+
+  if(workers==0 || per==0)
+    return -1;
+  pthread_once(&ws_once,ws_keyCreate);
+  span = (unsigned int)(per*SFS_AREA(SFS_WORK_SIZE)/sizeof(SFS_align));
+
+  ws->worker = worker;
+  ws->workers = workers;
+  ws->perWorker = per;
+  ws->next = 0;
+  ws->pass = 0;
+  ws->running = 0;
+  ws->quit = 0;
+  pthread_mutex_init(&ws->lock,WS_NULL);
+  pthread_cond_init(&ws->start,WS_NULL);
+  pthread_cond_init(&ws->done,WS_NULL);
+
+  for(i=0;i<workers;i++){
+    w = &worker[i];
+    SFS_ctxInitialize(&w->ctx,pool+i*per,per);
+    SFS_ctxArena(&w->ctx,arena+i*span,span*sizeof(SFS_align));
+    w->deque = slot+i*per;
+    w->head = 0;
+    w->tail = 0;
+    w->exe = WS_NULL;
+    w->ws = ws;
+    w->id = i;
+    w->stat.runs = 0;
+    w->stat.steals = 0;
+    w->stat.busy = 0.0;
+    w->stat.wall = 0.0;
+    pthread_mutex_init(&w->lock,WS_NULL);
+  }
+  for(i=1;i<workers;i++){
+    if(pthread_create(&worker[i].thread,WS_NULL,ws_thread,&worker[i])!=0){
+      ws->workers = i;
+      SFS_wsShutdown(ws);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+void SFS_wsShutdown(SFS_ws *ws)
+{
+  unsigned int i;
+
+  pthread_mutex_lock(&ws->lock);
+  ws->quit = 1;
+  pthread_cond_broadcast(&ws->start);
+  pthread_mutex_unlock(&ws->lock);
+
+  for(i=1;i<ws->workers;i++)
+    pthread_join(ws->worker[i].thread,WS_NULL);
+  for(i=0;i<ws->workers;i++)
+    pthread_mutex_destroy(&ws->worker[i].lock);
+  pthread_cond_destroy(&ws->done);
+  pthread_cond_destroy(&ws->start);
+  pthread_mutex_destroy(&ws->lock);
+}
+
+/* From inside a task the new task stays on the calling worker, whose
+   instance no other thread touches during the pass. */
+short SFS_wsFork(SFS_ws *ws,char *name,unsigned short order,void (*func)(void))
+{
+  SFS_wsWorker *w = pthread_getspecific(ws_key);
+  unsigned int i;
+
+  if(w!=WS_NULL && w->ws==ws && w->exe!=WS_NULL)
+    return SFS_ctxFork(&w->ctx,name,order,func);
+
+  for(i=0;i<ws->workers;i++){
+    w = &ws->worker[ws->next];
+    if(++ws->next>=ws->workers)
+      ws->next = 0;
+    if(SFS_ctxFork(&w->ctx,name,order,func))
+      return -1;
+  }
+
+  return 0;
+}
+
+/* Same placement as SFS_wsFork for an entry point taking `arg`;
+   ws_run calls it as pEntry(pArg) like SFS_dispatch does. */
+short SFS_wsForkArg(SFS_ws *ws,char *name,unsigned short order,void (*func)(void *),void *arg)
+{
+  SFS_wsWorker *w = pthread_getspecific(ws_key);
+  unsigned int i;
+
+  if(w!=WS_NULL && w->ws==ws && w->exe!=WS_NULL)
+    return SFS_ctxForkArg(&w->ctx,name,order,func,arg);
+
+  for(i=0;i<ws->workers;i++){
+    w = &ws->worker[ws->next];
+    if(++ws->next>=ws->workers)
+      ws->next = 0;
+    if(SFS_ctxForkArg(&w->ctx,name,order,func,arg))
+      return -1;
+  }
+
+  return 0;
+}
+
+/* Runs every task once, spread over all workers.
+   Returns the number of task functions executed. */
+long SFS_wsDispatch(SFS_ws *ws)
+{
+  unsigned int i;
+  long tcnt = 0;
+  double start,wall;
+
+  for(i=0;i<ws->workers;i++)
+    tcnt += ws_fill(ws,&ws->worker[i]);
+
+  start = ws_now();
+  pthread_mutex_lock(&ws->lock);
+  ws->running = ws->workers-1;
+  ws->pass++;
+  pthread_cond_broadcast(&ws->start);
+  pthread_mutex_unlock(&ws->lock);
+
+  pthread_setspecific(ws_key,&ws->worker[0]);
+  ws_run(&ws->worker[0]);
+
+  pthread_mutex_lock(&ws->lock);
+  while(ws->running!=0)
+    pthread_cond_wait(&ws->done,&ws->lock);
+  pthread_mutex_unlock(&ws->lock);
+  wall = ws_now()-start;
+
+  for(i=0;i<ws->workers;i++)
+    ws->worker[i].stat.wall += wall;
+
+  return tcnt;
+}
+
+void *SFS_wsWork(void)
+{
+  SFS_wsWorker *w = pthread_getspecific(ws_key);
+
+  return (void *)w->exe->work;
+}
+
+/* The TCB is released when its owner's deque is next filled. */
+void SFS_wsKill(void)
+{
+  SFS_wsWorker *w = pthread_getspecific(ws_key);
+
+  w->exe->pFunction = ws_giveup;
+}
+
+short SFS_wsStats(SFS_ws *ws,unsigned int id,SFS_wsStat *stat)
+{
+  if(id>=ws->workers)
+    return -1;
+  *stat = ws->worker[id].stat;
+
+  return 0;
+}
+
+/*-------------------- static functions --------------------*/
+
+static void ws_keyCreate(void)
+{
+  pthread_key_create(&ws_key,WS_NULL);
+}
+
+static void *ws_thread(void *arg)
+{
+  SFS_wsWorker *w = arg;
+  SFS_ws *ws = w->ws;
+  unsigned long seen = 0;
+
+  pthread_setspecific(ws_key,w);
+  for(;;){
+    pthread_mutex_lock(&ws->lock);
+    while(ws->pass==seen && !ws->quit)
+      pthread_cond_wait(&ws->start,&ws->lock);
+    if(ws->quit){
+      pthread_mutex_unlock(&ws->lock);
+      break;
+    }
+    seen = ws->pass;
+    pthread_mutex_unlock(&ws->lock);
+
+    ws_run(w);
+
+    pthread_mutex_lock(&ws->lock);
+    if(--ws->running==0)
+      pthread_cond_signal(&ws->done);
+    pthread_mutex_unlock(&ws->lock);
+  }
+
+  return WS_NULL;
+}
+
+/* Only called between passes, when no worker is running.
+   Returns the number of tasks queued for the pass. */
+static unsigned int ws_fill(SFS_ws *ws,SFS_wsWorker *w)
+{
+  struct SFS_tg *sfs;
+  unsigned int cnt,i,k = 0;
+
+  cnt = SFS_ctxSnapshot(&w->ctx,w->deque,ws->perWorker);
+  for(i=0;i<cnt;i++){
+    sfs = w->deque[i];
+    if(sfs->pFunction==ws_giveup)
+      SFS_ctxRemove(&w->ctx,sfs);
+    else
+      w->deque[k++] = sfs;
+  }
+  w->head = 0;
+  w->tail = k;
+
+  return k;
+}
+
+static void ws_run(SFS_wsWorker *w)
+{
+  struct SFS_tg *sfs;
+  double start;
+
+  for(;;){
+    sfs = ws_pop(w);
+    if(sfs==WS_NULL){
+      sfs = ws_steal(w);
+      if(sfs==WS_NULL)
+        break;
+      w->stat.steals++;
+    }
+    w->exe = sfs;
+    start = ws_now();
+    if(sfs->pEntry!=(void (*)(void *))0)
+      (*sfs->pEntry)(sfs->pArg);
+    else
+      (*sfs->pFunction)();
+    w->stat.busy += ws_now()-start;
+    w->stat.runs++;
+  }
+  w->exe = WS_NULL;
+}
+
+static struct SFS_tg *ws_pop(SFS_wsWorker *w)
+{
+  struct SFS_tg *sfs = WS_NULL;
+
+  pthread_mutex_lock(&w->lock);
+  if(w->head<w->tail)
+    sfs = w->deque[w->head++];
+  pthread_mutex_unlock(&w->lock);
+
+  return sfs;
+}
+
+/* No task is added to a deque during a pass, so one empty sweep
+   over the other workers means the pass is done for this worker. */
+static struct SFS_tg *ws_steal(SFS_wsWorker *w)
+{
+  SFS_ws *ws = w->ws;
+  SFS_wsWorker *v;
+  struct SFS_tg *sfs = WS_NULL;
+  unsigned int i;
+
+  for(i=1;i<ws->workers && sfs==WS_NULL;i++){
+    v = &ws->worker[(w->id+i)%ws->workers];
+    pthread_mutex_lock(&v->lock);
+    if(v->head<v->tail)
+      sfs = v->deque[--v->tail];
+    pthread_mutex_unlock(&v->lock);
+  }
+
+  return sfs;
+}
+
+static void ws_giveup(void)
+{
+}
+
+static double ws_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (double)ts.tv_sec+(double)ts.tv_nsec*1e-9;
+}
@@ -0,0 +1,138 @@
+#ifndef __SFS_WS_INC__
+#define __SFS_WS_INC__
+
+#include <pthread.h>
+#include "sfs.h"
+
+/*******************************
+[ function organization - PlantUML ]
+
+@startuml
+!theme plain
+skinparam packageStyle rectangle
+skinparam defaultFontName Arial
+skinparam defaultFontSize 9
+skinparam ranksep 120
+skinparam nodesep 80
+skinparam packagePadding 16
+
+title sfs_ws.c - Work-Stealing Dispatcher
+
+package "Public API" {
+  class SFS_wsInitialize
+  class SFS_wsShutdown
+  class SFS_wsFork
+  class SFS_wsForkArg
+  class SFS_wsDispatch
+  class SFS_wsWork
+  class SFS_wsKill
+  class SFS_wsStats
+}
+
+package "Static Functions" {
+  class ws_thread
+  class ws_fill
+  class ws_run
+  class ws_pop
+  class ws_steal
+  class ws_giveup
+  class ws_now
+}
+
+package "SFS instance API" {
+  class SFS_ctxInitialize
+  class SFS_ctxArena
+  class SFS_ctxFork
+  class SFS_ctxSnapshot
+  class SFS_ctxRemove
+}
+
+SFS_wsInitialize -down-> SFS_ctxInitialize : per worker
+SFS_wsInitialize -down-> SFS_ctxArena : per worker
+SFS_wsInitialize -down-> ws_thread : starts
+SFS_wsFork -down-> SFS_ctxFork : calls
+SFS_wsForkArg -down-> SFS_ctxForkArg : calls
+SFS_wsDispatch -down-> ws_fill : calls
+SFS_wsDispatch -down-> ws_run : calls (worker 0)
+ws_thread -down-> ws_run : calls
+ws_fill -down-> SFS_ctxSnapshot : calls
+ws_fill -down-> SFS_ctxRemove : calls
+ws_run -down-> ws_pop : calls
+ws_run -down-> ws_steal : calls
+ws_run -down-> ws_now : calls
+SFS_wsKill -down-> ws_giveup : marks
+
+@enduml
+*******************************/
+
+/* Per-worker counters.  busy/wall give the utilization of a worker. */
+typedef struct SFS_wsStat_tg {
+  unsigned long runs;     /* task functions executed */
+  unsigned long steals;   /* of which taken from another worker's deque */
+  double busy;            /* seconds spent inside task functions */
+  double wall;            /* seconds covered by dispatch passes */
+} SFS_wsStat;
+
+typedef struct SFS_wsWorker_tg {
+  SFS_ctx ctx;                /* owns this worker's TCBs, kept in order */
+  struct SFS_tg **deque;      /* ready entries of the current pass */
+  unsigned int head,tail;     /* owner pops head, thieves take tail */
+  pthread_mutex_t lock;       /* guards head/tail */
+  struct SFS_tg *exe;         /* task running on this worker */
+  struct SFS_ws_tg *ws;
+  unsigned int id;
+  pthread_t thread;
+  SFS_wsStat stat;
+#if SFS_CACHE_LINE > 0
+  char guard[SFS_CACHE_LINE]; /* keeps neighbouring workers off this line */
+#endif
+} SFS_wsWorker;
+
+typedef struct SFS_ws_tg {
+  SFS_wsWorker *worker;
+  unsigned int workers;
+  unsigned int perWorker;
+  unsigned int next;          /* round-robin fork target */
+  pthread_mutex_t lock;       /* guards pass/running/quit */
+  pthread_cond_t start,done;
+  unsigned long pass;
+  unsigned int running;
+  int quit;
+} SFS_ws;
+
+/* Storage for `n` workers holding up to `per` tasks each, with a
+   work area of SFS_WORK_SIZE bytes per task. */
+#define SFS_WS_STORAGE(name,n,per) \
+  static SFS_wsWorker name##_worker[n]; \
+  static struct SFS_tg name##_pool[(n)*(per)]; \
+  static struct SFS_tg *name##_slot[(n)*(per)]; \
+  static SFS_ARENA(name##_arena,(n)*(per),SFS_WORK_SIZE)
+
+extern short SFS_wsInitialize(SFS_ws *,SFS_wsWorker *,unsigned int,struct SFS_tg *,struct SFS_tg **,SFS_align *,unsigned int);
+extern void SFS_wsShutdown(SFS_ws *);
+extern short SFS_wsFork(SFS_ws *,char *,unsigned short,void (*)(void));
+extern short SFS_wsForkArg(SFS_ws *,char *,unsigned short,void (*)(void *),void *);
+extern long SFS_wsDispatch(SFS_ws *);
+extern void *SFS_wsWork(void);
+extern void SFS_wsKill(void);
+extern short SFS_wsStats(SFS_ws *,unsigned int,SFS_wsStat *);
+
+/* [ Usage example ]
+
+SFS_WS_STORAGE(farm, 4, 64);
+static SFS_ws ws;
+
+void task(void)
+{
+  struct my_work *w = SFS_wsWork();
+  ...
+}
+
+SFS_wsInitialize(&ws, farm_worker, 4, farm_pool, farm_slot, farm_arena, 64);
+SFS_wsFork(&ws, "TASK", 0, task);
+while(SFS_wsDispatch(&ws));
+SFS_wsShutdown(&ws);
+
+*/
+
+#endif
@@ -1,6 +1,6 @@
 /************************************************
   Simple Function Scheduler
-  
+
   $Id$
 *************************************************/
 /*
@@ -9,260 +9,2431 @@
 */
 #define dbg_printf(s)   /**/
 
-#include "sfs.h"
+#include "sfs.h"
+
+#define SFS_NULL ((struct SFS_tg *)0)
+#define SFS_SHORT_MAX 0x7FFF
+#define SFS_LEVEL_TOP (SFS_ORDER_LEVELS-1)
+#define SFS_LEVEL(o) ((o) < SFS_LEVEL_TOP ? (o):SFS_LEVEL_TOP)
+/* handle = generation(11bit) : pool index + 1(20bit) */
+#define SFS_INDEX_BITS 20
+#define SFS_INDEX_MASK ((1UL << SFS_INDEX_BITS) - 1)
+#define SFS_GEN_MASK 0x7FF
+/* SFS_tg.state */
+#define SFS_PERIODIC 0x0001
+#define SFS_DOZE 0x0002     /* asked to sleep while running */
+#define SFS_TIMED 0x0004    /* on the wheel; level holds level*32+slot */
+#define SFS_KILLED 0x0008   /* killed; off the list, released at pass end */
+#define SFS_MOVED 0x0010    /* order changed; on pMoved once it returned */
+#define SFS_SUSPENDED 0x0020 /* off every queue until resumed; DOZE: resume on the wheel */
+#define SFS_WAITING 0x0040  /* off every queue until mail arrives, as SFS_SUSPENDED */
+#define SFS_PENDING 0x0080  /* off every queue until its event flags are set */
+#define SFS_NAPPING 0x0100  /* backed off; on pNap until its pass comes */
+#define SFS_OFF (SFS_SUSPENDED|SFS_WAITING|SFS_PENDING|SFS_NAPPING)
+#define SFS_WHEEL_MASK (SFS_WHEEL_SLOTS-1)
+#define SFS_WHEEL_SPAN (1UL << (SFS_WHEEL_BITS*SFS_WHEEL_LEVELS))
+#define SFS_LONG_HALF (~0UL >> 1)
+/* a <= b on a wrapping tick counter */
+#define SFS_NOT_AFTER(a,b) ((unsigned long)((b)-(a)) <= SFS_LONG_HALF)
+#define SFS_NOTIMER ((unsigned long (*)(void))0)
+#define SFS_NOIDLE ((void (*)(unsigned long))0)
+#define SFS_BLK_NULL ((SFS_blk *)0)
+#define SFS_NOENTRY ((void (*)(void *))0)
+#define SFS_NOHEAP ((struct SFS_tg **)0)
+#define SFS_NOQUEUE ((SFS_queue *)0)
+#define SFS_NOCMD ((SFS_cmd *)0)
+/* off every queue; the running task only leaves them once it returns */
+#define SFS_PARKED(ctx,sfs) (((sfs)->state & SFS_OFF) && (sfs)!=(ctx)->exe)
+#define SFS_NOMAIL ((void **)0)
+#define SFS_NOFLAGS ((SFS_flags *)0)
+#define SFS_EARLIEST(ctx) ((ctx)->heapCount ? (ctx)->pHeap[0]:SFS_NULL)
+
+/*-------------------- public function --------------------*/
+short SFS_initialize(void);
+short SFS_initializePool(struct SFS_tg *,unsigned int);
+short SFS_dispatch(void);
+short SFS_dispatchFor(unsigned long);
+short SFS_fork(char *,short,void (*)());
+short SFS_forkSize(char *,short,void (*)(),unsigned int);
+short SFS_forkArg(char *,short,void (*)(void *),void *);
+short SFS_adopt(const SFS_entry *,unsigned int);
+short SFS_arena(void *,unsigned int);
+short SFS_names(struct SFS_tg **,unsigned int);
+void *SFS_work(void);
+void *SFS_otherWork(char *);
+short SFS_kill(void);
+short SFS_killByName(char *);
+short SFS_killHandle(SFS_handle);
+short SFS_change(char *,short,void (*)());
+SFS_handle SFS_lookup(char *);
+void *SFS_workOf(SFS_handle);
+void SFS_timer(unsigned long (*)(void));
+short SFS_forkPeriodic(char *,short,void (*)(),unsigned long);
+short SFS_sleep(unsigned long);
+short SFS_report(short);
+void SFS_idle(void (*)(unsigned long));
+unsigned long SFS_next(void);
+#ifdef SFS_STATS
+void SFS_probe(unsigned long (*)(void));
+struct SFS_tg *SFS_stats(struct SFS_tg *);
+#endif
+short SFS_suspend(char *);
+short SFS_resume(char *);
+short SFS_group(char *,unsigned long);
+unsigned int SFS_suspendGroup(unsigned long);
+unsigned int SFS_resumeGroup(unsigned long);
+short SFS_mailbox(char *,void **,unsigned int);
+short SFS_send(SFS_handle,void *);
+void *SFS_recv(void);
+void SFS_flagsInit(SFS_flags *,unsigned long);
+unsigned int SFS_setFlags(SFS_flags *,unsigned long);
+void SFS_clearFlags(SFS_flags *,unsigned long);
+unsigned long SFS_waitAny(SFS_flags *,unsigned long);
+unsigned long SFS_waitAll(SFS_flags *,unsigned long);
+short SFS_wake(SFS_handle);
+void SFS_listen(SFS_queue *);
+short SFS_queueInit(SFS_queue *,SFS_cmd *,unsigned long,int (*)(volatile unsigned long *,unsigned long,unsigned long),void (*)(void));
+short SFS_postFork(SFS_queue *,char *,short,void (*)());
+short SFS_postKill(SFS_queue *,SFS_handle);
+short SFS_postWake(SFS_queue *,SFS_handle);
+short SFS_postFlags(SFS_queue *,SFS_flags *,unsigned long);
+short SFS_policy(short,struct SFS_tg **,unsigned int);
+short SFS_deadline(char *,unsigned long);
+#ifdef SFS_TRACE
+short SFS_trace(SFS_event *,unsigned long,unsigned long (*)(void));
+unsigned long SFS_traceRead(SFS_event *,unsigned long);
+char *SFS_traceName(unsigned int);
+#endif
+/*------------------------------*/
+short SFS_ctxInitialize(SFS_ctx *,struct SFS_tg *,unsigned int);
+short SFS_ctxDispatch(SFS_ctx *);
+short SFS_ctxDispatchFor(SFS_ctx *,unsigned long);
+short SFS_ctxFork(SFS_ctx *,char *,short,void (*)());
+short SFS_ctxForkSize(SFS_ctx *,char *,short,void (*)(),unsigned int);
+short SFS_ctxForkArg(SFS_ctx *,char *,short,void (*)(void *),void *);
+short SFS_ctxAdopt(SFS_ctx *,const SFS_entry *,unsigned int);
+short SFS_ctxArena(SFS_ctx *,void *,unsigned int);
+short SFS_ctxNames(SFS_ctx *,struct SFS_tg **,unsigned int);
+void *SFS_ctxWork(SFS_ctx *);
+void *SFS_ctxOtherWork(SFS_ctx *,char *);
+short SFS_ctxKill(SFS_ctx *);
+short SFS_ctxKillByName(SFS_ctx *,char *);
+short SFS_ctxKillHandle(SFS_ctx *,SFS_handle);
+short SFS_ctxChange(SFS_ctx *,char *,short,void (*)());
+SFS_handle SFS_ctxLookup(SFS_ctx *,char *);
+void *SFS_ctxWorkOf(SFS_ctx *,SFS_handle);
+void SFS_ctxTimer(SFS_ctx *,unsigned long (*)(void));
+short SFS_ctxForkPeriodic(SFS_ctx *,char *,short,void (*)(),unsigned long);
+short SFS_ctxSleep(SFS_ctx *,unsigned long);
+short SFS_ctxReport(SFS_ctx *,short);
+void SFS_ctxIdle(SFS_ctx *,void (*)(unsigned long));
+unsigned long SFS_ctxNext(SFS_ctx *);
+#ifdef SFS_STATS
+void SFS_ctxProbe(SFS_ctx *,unsigned long (*)(void));
+struct SFS_tg *SFS_ctxStats(SFS_ctx *,struct SFS_tg *);
+#endif
+short SFS_ctxPolicy(SFS_ctx *,short,struct SFS_tg **,unsigned int);
+short SFS_ctxDeadline(SFS_ctx *,char *,unsigned long);
+short SFS_ctxSuspend(SFS_ctx *,char *);
+short SFS_ctxResume(SFS_ctx *,char *);
+short SFS_ctxGroup(SFS_ctx *,char *,unsigned long);
+unsigned int SFS_ctxSuspendGroup(SFS_ctx *,unsigned long);
+unsigned int SFS_ctxResumeGroup(SFS_ctx *,unsigned long);
+short SFS_ctxMailbox(SFS_ctx *,char *,void **,unsigned int);
+short SFS_ctxSend(SFS_ctx *,SFS_handle,void *);
+void *SFS_ctxRecv(SFS_ctx *);
+unsigned int SFS_ctxSetFlags(SFS_ctx *,SFS_flags *,unsigned long);
+unsigned long SFS_ctxWaitAny(SFS_ctx *,SFS_flags *,unsigned long);
+unsigned long SFS_ctxWaitAll(SFS_ctx *,SFS_flags *,unsigned long);
+short SFS_ctxWake(SFS_ctx *,SFS_handle);
+void SFS_ctxListen(SFS_ctx *,SFS_queue *);
+#ifdef SFS_TRACE
+short SFS_ctxTrace(SFS_ctx *,SFS_event *,unsigned long,unsigned long (*)(void));
+unsigned long SFS_ctxTraceRead(SFS_ctx *,SFS_event *,unsigned long);
+char *SFS_ctxTraceName(SFS_ctx *,unsigned int);
+#endif
+unsigned int SFS_ctxSnapshot(SFS_ctx *,struct SFS_tg **,unsigned int);
+short SFS_ctxRemove(SFS_ctx *,struct SFS_tg *);
+
+/*-------------------- static function & variable --------------------*/
+/* The default instance behind the context-free API. */
+static struct SFS_tg SFS[SFS_TASK_MAX];
+static SFS_ARENA(SFS_heap,SFS_TASK_MAX,SFS_WORK_SIZE);
+static SFS_ctx SFS_default;
+
+static void none(void){ return; }
+static struct SFS_tg * SFS_obtain(SFS_ctx *);
+static struct SFS_tg * SFS_spawn(SFS_ctx *,char *,short,void (*)(),unsigned int);
+static struct SFS_tg * SFS_prepare(SFS_ctx *,char *,short,void (*)(),unsigned int);
+static void SFS_regist(SFS_ctx *,struct SFS_tg *);
+static void SFS_link(SFS_ctx *,struct SFS_tg *,struct SFS_tg *);
+static void SFS_unlink(SFS_ctx *,struct SFS_tg *);
+static short SFS_below(SFS_ctx *,unsigned short);
+static short SFS_fls(unsigned long);
+static void SFS_release(SFS_ctx *,struct SFS_tg *);
+static short SFS_run(SFS_ctx *,int,unsigned long);
+static void SFS_reap(SFS_ctx *,struct SFS_tg *);
+static void SFS_drop(SFS_ctx *,struct SFS_tg *);
+static void SFS_move(SFS_ctx *,struct SFS_tg *);
+static short SFS_ready(SFS_ctx *,struct SFS_tg *);
+static void SFS_detach(SFS_ctx *,struct SFS_tg *);
+static short SFS_park(SFS_ctx *,struct SFS_tg *,unsigned short);
+static short SFS_unpark(SFS_ctx *,struct SFS_tg *,unsigned short);
+static void SFS_registFront(SFS_ctx *,struct SFS_tg *);
+static void SFS_enqueue(SFS_ctx *,struct SFS_tg *);
+static void SFS_dequeue(SFS_ctx *,struct SFS_tg *);
+static void SFS_sift(SFS_ctx *,struct SFS_tg *,unsigned int);
+static int SFS_before(struct SFS_tg *,struct SFS_tg *);
+static void SFS_defer(SFS_ctx *,struct SFS_tg *);
+static unsigned long SFS_wait(SFS_ctx *,SFS_flags *,unsigned long,unsigned short);
+static void SFS_unwait(struct SFS_tg *);
+static SFS_cmd * SFS_claim(SFS_queue *,unsigned long *);
+static void SFS_publish(SFS_queue *,SFS_cmd *,unsigned long);
+static void SFS_drain(SFS_ctx *);
+static void SFS_wakeup(SFS_ctx *,struct SFS_tg *);
+static void SFS_nap(SFS_ctx *,struct SFS_tg *);
+static void SFS_unnap(SFS_ctx *,struct SFS_tg *);
+static void SFS_rouse(SFS_ctx *);
+static unsigned short SFS_nextNap(SFS_ctx *);
+static unsigned long SFS_clock(SFS_ctx *);
+static struct SFS_tg * SFS_byHandle(SFS_ctx *,SFS_handle);
+static void SFS_discard(SFS_ctx *,struct SFS_tg *);
+static struct SFS_tg * SFS_find(SFS_ctx *,char *);
+static void SFS_index(SFS_ctx *,struct SFS_tg *);
+static void SFS_unindex(struct SFS_tg *);
+static unsigned int SFS_hash(char *);
+static void SFS_advance(SFS_ctx *);
+static void SFS_expire(SFS_ctx *);
+static void SFS_settle(SFS_ctx *,struct SFS_tg *);
+static void SFS_arm(SFS_ctx *,struct SFS_tg *);
+static void SFS_disarm(SFS_ctx *,struct SFS_tg *);
+static short SFS_ffs(unsigned long);
+#ifdef SFS_STATS
+static void SFS_account(SFS_ctx *,struct SFS_tg *,unsigned long);
+#endif
+#ifdef SFS_TRACE
+static void SFS_record(SFS_ctx *,struct SFS_tg *,unsigned short,unsigned long);
+#define SFS_NOW(ctx) ((ctx)->pStamp!=SFS_NOTIMER ? (*(ctx)->pStamp)():0)
+#endif
+static char * SFS_carve(SFS_ctx *,unsigned int);
+static void SFS_uncarve(SFS_ctx *,char *);
+/*------------------------------*/
+static char *strncpy(char *,char *,unsigned int);
+static int strcnt(char *);
+static int strncmp(char *,char *,unsigned int);
+
+/*-------------------- public function define --------------------*/
+short SFS_initialize(void)
+{
+  SFS_ctxInitialize(&SFS_default,SFS,SFS_TASK_MAX);
+
+  return SFS_ctxArena(&SFS_default,SFS_heap,sizeof(SFS_heap));
+}
+
+/* Keeps the built-in arena, so a caller that forks no more than
+   SFS_TASK_MAX tasks of SFS_WORK_SIZE needs no SFS_arena() call. */
+short SFS_initializePool(struct SFS_tg *pool,unsigned int count)
+{
+  if(SFS_ctxInitialize(&SFS_default,pool,count)!=0)
+    return -1;
+
+  return SFS_ctxArena(&SFS_default,SFS_heap,sizeof(SFS_heap));
+}
+
+short SFS_dispatch(void)
+{
+  return SFS_ctxDispatch(&SFS_default);
+}
+
+short SFS_dispatchFor(unsigned long budget)
+{
+  return SFS_ctxDispatchFor(&SFS_default,budget);
+}
+
+short SFS_fork(char *name,short order,void (*func)())
+{
+  return SFS_ctxFork(&SFS_default,name,order,func);
+}
+
+short SFS_forkSize(char *name,short order,void (*func)(),unsigned int size)
+{
+  return SFS_ctxForkSize(&SFS_default,name,order,func,size);
+}
+
+short SFS_forkArg(char *name,short order,void (*func)(void *),void *arg)
+{
+  return SFS_ctxForkArg(&SFS_default,name,order,func,arg);
+}
+
+short SFS_adopt(const SFS_entry *table,unsigned int count)
+{
+  return SFS_ctxAdopt(&SFS_default,table,count);
+}
+
+short SFS_arena(void *arena,unsigned int size)
+{
+  return SFS_ctxArena(&SFS_default,arena,size);
+}
+
+short SFS_names(struct SFS_tg **table,unsigned int count)
+{
+  return SFS_ctxNames(&SFS_default,table,count);
+}
+
+void *SFS_work(void)
+{
+  return SFS_ctxWork(&SFS_default);
+}
+
+void *SFS_otherWork(char *name)
+{
+  return SFS_ctxOtherWork(&SFS_default,name);
+}
+
+short SFS_kill(void)
+{
+  return SFS_ctxKill(&SFS_default);
+}
+
+short SFS_killByName(char *name)
+{
+  return SFS_ctxKillByName(&SFS_default,name);
+}
+
+short SFS_killHandle(SFS_handle handle)
+{
+  return SFS_ctxKillHandle(&SFS_default,handle);
+}
+
+short SFS_change(char *name,short order,void (*func)())
+{
+  return SFS_ctxChange(&SFS_default,name,order,func);
+}
+
+SFS_handle SFS_lookup(char *name)
+{
+  return SFS_ctxLookup(&SFS_default,name);
+}
+
+void *SFS_workOf(SFS_handle handle)
+{
+  return SFS_ctxWorkOf(&SFS_default,handle);
+}
+
+void SFS_timer(unsigned long (*timer)(void))
+{
+  SFS_ctxTimer(&SFS_default,timer);
+}
+
+short SFS_forkPeriodic(char *name,short order,void (*func)(),unsigned long period)
+{
+  return SFS_ctxForkPeriodic(&SFS_default,name,order,func,period);
+}
+
+short SFS_sleep(unsigned long ticks)
+{
+  return SFS_ctxSleep(&SFS_default,ticks);
+}
+
+short SFS_report(short hint)
+{
+  return SFS_ctxReport(&SFS_default,hint);
+}
+
+void SFS_idle(void (*idle)(unsigned long))
+{
+  SFS_ctxIdle(&SFS_default,idle);
+}
+
+unsigned long SFS_next(void)
+{
+  return SFS_ctxNext(&SFS_default);
+}
+
+#ifdef SFS_STATS
+void SFS_probe(unsigned long (*probe)(void))
+{
+  SFS_ctxProbe(&SFS_default,probe);
+}
+
+struct SFS_tg *SFS_stats(struct SFS_tg *sfs)
+{
+  return SFS_ctxStats(&SFS_default,sfs);
+}
+#endif
+
+short SFS_suspend(char *name)
+{
+  return SFS_ctxSuspend(&SFS_default,name);
+}
+
+short SFS_resume(char *name)
+{
+  return SFS_ctxResume(&SFS_default,name);
+}
+
+short SFS_group(char *name,unsigned long mask)
+{
+  return SFS_ctxGroup(&SFS_default,name,mask);
+}
+
+unsigned int SFS_suspendGroup(unsigned long mask)
+{
+  return SFS_ctxSuspendGroup(&SFS_default,mask);
+}
+
+unsigned int SFS_resumeGroup(unsigned long mask)
+{
+  return SFS_ctxResumeGroup(&SFS_default,mask);
+}
+
+short SFS_mailbox(char *name,void **slot,unsigned int count)
+{
+  return SFS_ctxMailbox(&SFS_default,name,slot,count);
+}
+
+short SFS_send(SFS_handle handle,void *msg)
+{
+  return SFS_ctxSend(&SFS_default,handle,msg);
+}
+
+void *SFS_recv(void)
+{
+  return SFS_ctxRecv(&SFS_default);
+}
+
+/* Flag groups are plain data until a task waits on one, so setting
+   them up and clearing flags needs no instance. */
+void SFS_flagsInit(SFS_flags *flags,unsigned long bits)
+{
+  flags->bits = bits;
+  flags->watched = 0;
+  flags->pWaiter = SFS_NULL;
+}
+
+unsigned int SFS_setFlags(SFS_flags *flags,unsigned long bits)
+{
+  return SFS_ctxSetFlags(&SFS_default,flags,bits);
+}
+
+/* Clearing never makes a task ready, so waiters are not looked at. */
+void SFS_clearFlags(SFS_flags *flags,unsigned long bits)
+{
+  flags->bits &= ~bits;
+}
+
+unsigned long SFS_waitAny(SFS_flags *flags,unsigned long mask)
+{
+  return SFS_ctxWaitAny(&SFS_default,flags,mask);
+}
+
+unsigned long SFS_waitAll(SFS_flags *flags,unsigned long mask)
+{
+  return SFS_ctxWaitAll(&SFS_default,flags,mask);
+}
+
+short SFS_wake(SFS_handle handle)
+{
+  return SFS_ctxWake(&SFS_default,handle);
+}
+
+void SFS_listen(SFS_queue *queue)
+{
+  SFS_ctxListen(&SFS_default,queue);
+}
+
+/* Producers only ever see the queue, never an instance, so the post
+   functions take no SFS_ctx. */
+short SFS_queueInit(SFS_queue *queue,SFS_cmd *slot,unsigned long count,int (*cas)(volatile unsigned long *,unsigned long,unsigned long),void (*fence)(void))
+{
+  unsigned long i;
+
+  if(queue==SFS_NOQUEUE || slot==SFS_NOCMD || count==0 || (count & (count - 1)))
+    return -1;
+
+  for(i=0;i<count;i++)
+    slot[i].seq = i;
+  queue->pSlot = slot;
+  queue->mask = count - 1;
+  queue->head = 0;
+  queue->tail = 0;
+  queue->pCas = cas;
+  queue->pFence = fence;
+  queue->failed = 0;
+
+  return 0;
+}
+
+short SFS_postFork(SFS_queue *queue,char *name,short order,void (*func)())
+{
+  SFS_cmd * cmd;
+  unsigned long pos;
+
+  cmd = SFS_claim(queue,&pos);
+  if(cmd==SFS_NOCMD)
+    return -1;
+
+  cmd->op = SFS_CMD_FORK;
+  strncpy(cmd->name,name,SFS_NAME_SIZE-1);
+  cmd->order = order;
+  cmd->pFunction = func;
+  SFS_publish(queue,cmd,pos);
+
+  return 0;
+}
+
+short SFS_postKill(SFS_queue *queue,SFS_handle handle)
+{
+  SFS_cmd * cmd;
+  unsigned long pos;
+
+  cmd = SFS_claim(queue,&pos);
+  if(cmd==SFS_NOCMD)
+    return -1;
+
+  cmd->op = SFS_CMD_KILL;
+  cmd->handle = handle;
+  SFS_publish(queue,cmd,pos);
+
+  return 0;
+}
+
+short SFS_postWake(SFS_queue *queue,SFS_handle handle)
+{
+  SFS_cmd * cmd;
+  unsigned long pos;
+
+  cmd = SFS_claim(queue,&pos);
+  if(cmd==SFS_NOCMD)
+    return -1;
+
+  cmd->op = SFS_CMD_WAKE;
+  cmd->handle = handle;
+  SFS_publish(queue,cmd,pos);
+
+  return 0;
+}
+
+short SFS_postFlags(SFS_queue *queue,SFS_flags *flags,unsigned long bits)
+{
+  SFS_cmd * cmd;
+  unsigned long pos;
+
+  cmd = SFS_claim(queue,&pos);
+  if(cmd==SFS_NOCMD)
+    return -1;
+
+  cmd->op = SFS_CMD_FLAGS;
+  cmd->pFlags = flags;
+  cmd->bits = bits;
+  SFS_publish(queue,cmd,pos);
+
+  return 0;
+}
+
+short SFS_policy(short policy,struct SFS_tg **heap,unsigned int count)
+{
+  return SFS_ctxPolicy(&SFS_default,policy,heap,count);
+}
+
+short SFS_deadline(char *name,unsigned long ticks)
+{
+  return SFS_ctxDeadline(&SFS_default,name,ticks);
+}
+
+#ifdef SFS_TRACE
+short SFS_trace(SFS_event *ring,unsigned long count,unsigned long (*stamp)(void))
+{
+  return SFS_ctxTrace(&SFS_default,ring,count,stamp);
+}
+
+unsigned long SFS_traceRead(SFS_event *out,unsigned long max)
+{
+  return SFS_ctxTraceRead(&SFS_default,out,max);
+}
+
+char *SFS_traceName(unsigned int task)
+{
+  return SFS_ctxTraceName(&SFS_default,task);
+}
+#endif
+
+/*-------------------- context function define --------------------*/
+/* The pool is threaded into a singly linked free list through pBack.
+   SFS_obtain pops and SFS_release pushes at its head, so fork/kill
+   cost does not depend on the pool size.  A handle holds the TCB index
+   in SFS_INDEX_BITS, so a larger pool is refused. */
+short SFS_ctxInitialize(SFS_ctx *ctx,struct SFS_tg *pool,unsigned int count)
+{
+  unsigned int iLoop;
+
+  if(ctx==(SFS_ctx *)0 || pool==SFS_NULL || count==0 ||
+     (unsigned long)count > SFS_INDEX_MASK)
+    return -1;
+
+  for(iLoop=0;iLoop<count;iLoop++){
+    pool[iLoop].name[0] = 0x00;
+    pool[iLoop].order = 0x0000;
+    pool[iLoop].pFront = SFS_NULL;
+    pool[iLoop].pBack = &pool[iLoop+1];
+    pool[iLoop].pFunction = none;
+    pool[iLoop].pHash = SFS_NULL;
+    pool[iLoop].ppHash = (struct SFS_tg **)0;
+    pool[iLoop].gen = 0;
+    pool[iLoop].state = 0;
+    pool[iLoop].work = (char *)0;
+    pool[iLoop].workSize = 0;
+    pool[iLoop].slot = 0;
+  }
+  pool[count-1].pBack = SFS_NULL;
+
+  for(iLoop=0;iLoop<SFS_ORDER_LEVELS;iLoop++)
+    ctx->pLast[iLoop] = SFS_NULL;
+  for(iLoop=0;iLoop<SFS_LEVEL_WORDS;iLoop++)
+    ctx->bmLevel[iLoop] = 0;
+  ctx->bmWord = 0;
+  for(iLoop=0;iLoop<SFS_HASH_SIZE;iLoop++)
+    ctx->pBucket[iLoop] = SFS_NULL;
+  ctx->pName = ctx->pBucket;
+  ctx->nameMask = SFS_HASH_SIZE-1;
+  for(iLoop=0;iLoop<SFS_WHEEL_LEVELS*SFS_WHEEL_SLOTS;iLoop++)
+    ctx->pWheel[iLoop/SFS_WHEEL_SLOTS][iLoop%SFS_WHEEL_SLOTS] = SFS_NULL;
+  for(iLoop=0;iLoop<SFS_WHEEL_LEVELS;iLoop++)
+    ctx->bmWheel[iLoop] = 0;
+  ctx->pTimer = SFS_NOTIMER;
+  ctx->now = 0;
+  ctx->tick = 1;
+  ctx->timed = 0;
+  for(iLoop=0;iLoop<SFS_BACKOFF_MAX;iLoop++)
+    ctx->pNap[iLoop] = SFS_NULL;
+  ctx->pass = 0;
+  ctx->napping = 0;
+  ctx->pIdle = SFS_NOIDLE;
+  ctx->pArena = (char *)0;
+  ctx->pTop = (char *)0;
+  ctx->pEnd = (char *)0;
+  ctx->pFree = SFS_BLK_NULL;
+  ctx->pReap = SFS_NULL;
+  ctx->pMoved = SFS_NULL;
+  ctx->open = 0;
+  ctx->ran = 0;
+  ctx->pQueue = SFS_NOQUEUE;
+  ctx->policy = SFS_POLICY_ORDER;
+  ctx->pHeap = SFS_NOHEAP;
+  ctx->heapCount = 0;
+#ifdef SFS_STATS
+  ctx->pProbe = SFS_NOTIMER;
+#endif
+#ifdef SFS_TRACE
+  ctx->pRing = (SFS_event *)0;
+  ctx->ringMask = 0;
+  ctx->ringHead = 0;
+  ctx->ringTail = 0;
+  ctx->pStamp = SFS_NOTIMER;
+#endif
+
+  ctx->pBase = pool;
+  ctx->poolSize = count;
+  ctx->pPool = pool;
+  ctx->pTask = SFS_NULL;
+  ctx->exe = SFS_NULL;
+  ctx->pNext = SFS_NULL;
+
+  return 0;
+}
+
+short SFS_ctxDispatch(SFS_ctx *ctx)
+{
+  return SFS_run(ctx,0,0UL);
+}
+
+/* Runs the pass until `budget` ticks of the injected timer have gone
+   by (task calls when there is no timer), always at least one task.
+   A pass cut short returns -1 and the next call carries on from the
+   next task due, so every task still runs once per pass.  A finished
+   pass returns what SFS_ctxDispatch would have. */
+short SFS_ctxDispatchFor(SFS_ctx *ctx,unsigned long budget)
+{
+  return SFS_run(ctx,1,budget);
+}
+
+short SFS_ctxFork(SFS_ctx *ctx,char *name,short order,void (*func)())
+{
+  return SFS_spawn(ctx,name,order,func,SFS_WORK_SIZE)!=SFS_NULL ? -1:0;
+}
+
+/* Same as SFS_ctxFork with a work area of `size` bytes.  Fails when
+   the arena cannot supply it. */
+short SFS_ctxForkSize(SFS_ctx *ctx,char *name,short order,void (*func)(),unsigned int size)
+{
+  return SFS_spawn(ctx,name,order,func,size)!=SFS_NULL ? -1:0;
+}
+
+/* Forks a task whose entry point takes `arg`, so one function can
+   serve many tasks without looking up its data by name. */
+short SFS_ctxForkArg(SFS_ctx *ctx,char *name,short order,void (*func)(void *),void *arg)
+{
+  struct SFS_tg * sfs;
+
+  /* pFunction only has to differ from none here */
+  sfs = SFS_spawn(ctx,name,order,(void (*)())func,SFS_WORK_SIZE);
+  if(sfs==SFS_NULL)
+    return 0;
+
+  sfs->pEntry = func;
+  sfs->pArg = arg;
+
+  return -1;
+}
+
+/* Forks every entry of a task table.  An entry whose order is not
+   below the current tail of the ready list is appended to it directly,
+   so a table written in ascending order (SFS_TABLE) costs no search at
+   all; any other entry falls back to the usual SFS_regist.  All or
+   nothing: -1 once every entry is linked, as SFS_fork returns.  When
+   the pool or the arena runs out, the entries linked by this call are
+   released again and 0 is returned.  Until then they are chained
+   through pWaiter, which only means something while pFlags is set. */
+short SFS_ctxAdopt(SFS_ctx *ctx,const SFS_entry *table,unsigned int count)
+{
+  struct SFS_tg * sfs;
+  struct SFS_tg * tail = SFS_NULL;
+  struct SFS_tg * adopted = SFS_NULL;
+  unsigned short level;
+  short word;
+  unsigned int i;
+
+  if(ctx->bmWord){
+    word = SFS_fls(ctx->bmWord);
+    tail = ctx->pLast[word*SFS_BITS + SFS_fls(ctx->bmLevel[word])];
+  }
+
+  for(i=0;i<count;i++){
+    sfs = SFS_prepare(ctx,table[i].name,table[i].order,table[i].pFunction,SFS_WORK_SIZE);
+    if(sfs==SFS_NULL){
+      while((sfs = adopted)!=SFS_NULL){
+        adopted = sfs->pWaiter;
+#ifdef SFS_TRACE
+        SFS_record(ctx,sfs,SFS_EV_KILL,SFS_NOW(ctx));
+#endif
+        SFS_discard(ctx,sfs);
+      }
+      return 0;
+    }
+    sfs->pWaiter = adopted;
+    adopted = sfs;
+
+    level = SFS_LEVEL(sfs->order);
+    if(ctx->policy==SFS_POLICY_EDF){
+      SFS_regist(ctx,sfs);
+    }else if(tail==SFS_NULL || level > tail->level || (level==tail->level && sfs->order >= tail->order)){
+      sfs->level = level;
+      SFS_link(ctx,sfs,tail);
+      ctx->pLast[level] = sfs;
+      ctx->bmLevel[level/SFS_BITS] |= 1UL << (level%SFS_BITS);
+      ctx->bmWord |= 1UL << (level/SFS_BITS);
+    }else{
+      SFS_regist(ctx,sfs);
+    }
+    if(sfs->pBack==SFS_NULL)
+      tail = sfs;
+  }
+
+  return -1;
+}
+
+/* Hands the instance a static arena for work areas.  Call it after
+   SFS_ctxInitialize(); the arena must be aligned like SFS_align,
+   which SFS_ARENA() takes care of. */
+short SFS_ctxArena(SFS_ctx *ctx,void *arena,unsigned int size)
+{
+  if(arena==(void *)0)
+    return -1;
+
+  ctx->pArena = (char *)arena;
+  ctx->pTop = ctx->pArena;
+  ctx->pEnd = ctx->pArena + size;
+  ctx->pFree = SFS_BLK_NULL;
+
+  return 0;
+}
+
+/* Hands the instance a caller-owned name index of `count` buckets, a
+   power of two; the tasks indexed so far move over.  Returns 0, or -1
+   for a count that is not a power of two. */
+short SFS_ctxNames(SFS_ctx *ctx,struct SFS_tg **table,unsigned int count)
+{
+  struct SFS_tg ** old = ctx->pName;
+  struct SFS_tg * sfs;
+  struct SFS_tg * rev;
+  unsigned int iLoop,buckets = ctx->nameMask + 1;
+
+  if(table==(struct SFS_tg **)0 || count==0 || (count & (count-1)))
+    return -1;
+  if(table==old)
+    return count==buckets ? 0:-1;
+
+  for(iLoop=0;iLoop<count;iLoop++)
+    table[iLoop] = SFS_NULL;
+  ctx->pName = table;
+  ctx->nameMask = count-1;
+  /* oldest first, so a shared name still finds the one indexed last */
+  for(iLoop=0;iLoop<buckets;iLoop++){
+    rev = SFS_NULL;
+    while((sfs = old[iLoop])!=SFS_NULL){
+      old[iLoop] = sfs->pHash;
+      sfs->pHash = rev;
+      rev = sfs;
+    }
+    while((sfs = rev)!=SFS_NULL){
+      rev = sfs->pHash;
+      SFS_index(ctx,sfs);
+    }
+  }
+
+  return 0;
+}
+
+/* The first run is on the next pass; later runs are `period` ticks
+   apart, measured from the previous due tick so they do not drift. */
+short SFS_ctxForkPeriodic(SFS_ctx *ctx,char *name,short order,void (*func)(),unsigned long period)
+{
+  struct SFS_tg * sfs;
+
+  if(period==0)
+    return 0;
+
+  sfs = SFS_spawn(ctx,name,order,func,SFS_WORK_SIZE);
+  if(sfs==SFS_NULL)
+    return 0;
+
+  sfs->period = period;
+  sfs->wake = SFS_clock(ctx);
+  sfs->state = SFS_PERIODIC;
+  /* under EDF a periodic task is due by its next release */
+  sfs->deadline = period;
+  if(sfs->slot){
+    SFS_unlink(ctx,sfs);
+    SFS_regist(ctx,sfs);
+  }
+
+  return -1;
+}
+
+/* Tick source for timed tasks, e.g. GetFreeRunCounter() from
+   libs/frcc.  It must count over the whole unsigned long range. */
+void SFS_ctxTimer(SFS_ctx *ctx,unsigned long (*timer)(void))
+{
+  ctx->pTimer = timer;
+  if(timer!=SFS_NOTIMER){
+    ctx->now = (*timer)();
+    ctx->tick = ctx->now + 1;
+  }
+}
+
+/* Called by the dispatcher, in place of a pass, whenever no task is
+   ready.  It gets SFS_ctxNext() and may block up to that many ticks;
+   SFS_FOREVER means only an external event can make a task ready. */
+void SFS_ctxIdle(SFS_ctx *ctx,void (*idle)(unsigned long))
+{
+  ctx->pIdle = idle;
+}
+
+/* Ticks from this pass to the next one that has a task to wake.
+   Within a level the first non-empty slot from the current position
+   holds the earliest tasks.  Delays beyond the wheel are reported at
+   the cascade that re-arms them.  A back-off counts passes; with a
+   timer, a tick spent in the idle hook stands for an empty pass, so a
+   backed-off task is due in as many ticks as it has passes left.
+   Without a timer the next pass is due at once, and a backed-off task
+   keeps the idle hook from sleeping. */
+unsigned long SFS_ctxNext(SFS_ctx *ctx)
+{
+  unsigned long span,up,bits,next = SFS_FOREVER,when,cascade;
+  unsigned short level,cur,slot;
+  struct SFS_tg * sfs;
+
+  if(ctx->napping){
+    if(ctx->pTimer==SFS_NOTIMER)
+      return 0;
+    next = SFS_nextNap(ctx);
+  }
+  if(ctx->timed==0 || ctx->pTimer==SFS_NOTIMER)
+    return next;
+
+  for(level=0;level<SFS_WHEEL_LEVELS;level++){
+    bits = ctx->bmWheel[level];
+    if(!bits)
+      continue;
+    span = 1UL << (level*SFS_WHEEL_BITS);
+    up = (ctx->tick + span - 1) & ~(span - 1);
+    cur = (up >> (level*SFS_WHEEL_BITS)) & SFS_WHEEL_MASK;
+    if(cur)
+      bits = ((bits >> cur) | (bits << (SFS_WHEEL_SLOTS - cur))) & 0xFFFFFFFFUL;
+    slot = (cur + SFS_ffs(bits)) & SFS_WHEEL_MASK;
+    cascade = up + ((slot - cur) & SFS_WHEEL_MASK) * span;
+    for(sfs=ctx->pWheel[level][slot];sfs!=SFS_NULL;sfs=sfs->pBack){
+      when = sfs->wake - cascade < span ? sfs->wake:cascade;
+      if(when - ctx->now < next)
+        next = when - ctx->now;
+    }
+  }
+
+  return next;
+}
+
+#ifdef SFS_STATS
+/* Clock read around every task call, e.g. a cycle counter or
+   GetFreeRunCounter().  Without one only the call count is kept. */
+void SFS_ctxProbe(SFS_ctx *ctx,unsigned long (*probe)(void))
+{
+  ctx->pProbe = probe;
+}
+
+/* Iterates over the live tasks of the pool: start with SFS_NULL and
+   pass the previous result back until SFS_NULL is returned. */
+struct SFS_tg *SFS_ctxStats(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  sfs = sfs==SFS_NULL ? ctx->pBase:sfs+1;
+
+  for(;sfs<ctx->pBase+ctx->poolSize;sfs++){
+    if(sfs->pFunction!=none)
+      return sfs;
+  }
+
+  return SFS_NULL;
+}
+#endif
+
+#ifdef SFS_TRACE
+/* Starts recording into `ring`, whose `count` must be a power of two;
+   0 entries (or a NULL ring) stops it.  `stamp` is read for every
+   record, e.g. GetFreeRunCounter() or a cycle counter. */
+short SFS_ctxTrace(SFS_ctx *ctx,SFS_event *ring,unsigned long count,unsigned long (*stamp)(void))
+{
+  if(count & (count - 1))
+    return -1;
+
+  ctx->pRing = count ? ring:(SFS_event *)0;
+  ctx->ringMask = count - 1;
+  ctx->ringHead = 0;
+  ctx->ringTail = 0;
+  ctx->pStamp = stamp;
+
+  return 0;
+}
+
+/* Moves up to `max` records, oldest first, out of the ring.  Records
+   overwritten before they were read are lost; returns how many were
+   copied. */
+unsigned long SFS_ctxTraceRead(SFS_ctx *ctx,SFS_event *out,unsigned long max)
+{
+  unsigned long n = 0;
+
+  if(ctx->pRing==(SFS_event *)0)
+    return 0;
+  if(ctx->ringHead - ctx->ringTail > ctx->ringMask + 1)
+    ctx->ringTail = ctx->ringHead - (ctx->ringMask + 1);
+
+  while(n < max && ctx->ringTail!=ctx->ringHead)
+    out[n++] = ctx->pRing[ctx->ringTail++ & ctx->ringMask];
+
+  return n;
+}
+
+/* Name of the task a record refers to; a released TCB keeps the name
+   of its last task until it is reused. */
+char *SFS_ctxTraceName(SFS_ctx *ctx,unsigned int task)
+{
+  if(task >= ctx->poolSize)
+    return (char *)0;
+
+  return ctx->pBase[task].name;
+}
+#endif
+
+/* Takes the running task off the ready list for `ticks` ticks once it
+   returns.  0 waits for the next tick. */
+short SFS_ctxSleep(SFS_ctx *ctx,unsigned long ticks)
+{
+  if(ctx->exe!=SFS_NULL){
+    ctx->exe->wake = ctx->now + ticks;
+    ctx->exe->state |= SFS_DOZE;
+  }
+  return 0;
+}
+
+/* Activity hint from the running task.  SFS_IDLE leaves it out of the
+   passes until its back-off is over, the back-off doubling on every
+   idle report up to SFS_BACKOFF_MAX; SFS_BUSY resets it.  Returns -1
+   outside a task or for an unknown hint. */
+short SFS_ctxReport(SFS_ctx *ctx,short hint)
+{
+  struct SFS_tg * exe = ctx->exe;
+
+  if(exe==SFS_NULL)
+    return -1;
+
+  if(hint==SFS_BUSY){
+    exe->backoff = 0;
+    SFS_unpark(ctx,exe,SFS_NAPPING);
+  }else if(hint==SFS_IDLE){
+    if(SFS_park(ctx,exe,SFS_NAPPING))
+      exe->backoff = exe->backoff==0 ? 2:
+                     exe->backoff < SFS_BACKOFF_MAX ? exe->backoff*2:SFS_BACKOFF_MAX;
+  }else{
+    return -1;
+  }
+  return 0;
+}
+
+void *SFS_ctxWork(SFS_ctx *ctx)
+{
+  return (void *)ctx->exe->work;
+}
+
+void *SFS_ctxOtherWork(SFS_ctx *ctx,char *name)
+{
+  struct SFS_tg * sfs;
+
+  sfs = SFS_find(ctx,name);
+
+  if(sfs==SFS_NULL)
+    return (void *)0;
+
+  return (void *)sfs->work;
+}
+
+short SFS_ctxKill(SFS_ctx *ctx)
+{
+  if(ctx->exe!=SFS_NULL){
+    ctx->exe->state |= SFS_KILLED;
+  }
+dbg_printf("kill !\n");
+  return 0;
+}
+
+/* Kills another task, ready or sleeping: it leaves the list at once and
+   will not run again.  Naming the running task is the same as
+   SFS_ctxKill.  Returns -1 if there is no such task. */
+short SFS_ctxKillByName(SFS_ctx *ctx,char *name)
+{
+  struct SFS_tg * sfs;
+
+  sfs = SFS_find(ctx,name);
+  if(sfs==SFS_NULL)
+    return -1;
+
+  SFS_reap(ctx,sfs);
+  return 0;
+}
+
+/* As SFS_ctxKillByName, without the name lookup.  A stale handle
+   (the task already gone) is rejected. */
+short SFS_ctxKillHandle(SFS_ctx *ctx,SFS_handle handle)
+{
+  struct SFS_tg * sfs;
+
+  sfs = SFS_byHandle(ctx,handle);
+  if(sfs==SFS_NULL)
+    return -1;
+
+  SFS_reap(ctx,sfs);
+  return 0;
+}
+
+short SFS_ctxChange(SFS_ctx *ctx,char *name,short order,void (*func)())
+{
+  struct SFS_tg * exe = ctx->exe;
+
+  if(exe!=SFS_NULL){
+    SFS_unindex(exe);
+    strncpy(exe->name,name,SFS_NAME_SIZE-1);
+    SFS_index(ctx,exe);
+    /* still linked by its old order until it returns (SFS_move) */
+    exe->reorder = order;
+    if(exe->order!=exe->reorder)
+      exe->state |= SFS_MOVED;
+    else
+      exe->state &= ~SFS_MOVED;
+    exe->pFunction = func;
+    exe->pEntry = SFS_NOENTRY;
+#ifdef SFS_TRACE
+    SFS_record(ctx,exe,SFS_EV_CHANGE,SFS_NOW(ctx));
+#endif
+  }
+dbg_printf("change !!\n");
+  return 0;
+}
+
+/* A handle stays valid until the task is killed; the generation in it
+   no longer matches once the TCB is released and reused. */
+SFS_handle SFS_ctxLookup(SFS_ctx *ctx,char *name)
+{
+  struct SFS_tg * sfs;
+
+  sfs = SFS_find(ctx,name);
+
+  if(sfs==SFS_NULL)
+    return SFS_NOHANDLE;
+
+  return ((unsigned long)sfs->gen << SFS_INDEX_BITS) | (unsigned long)(sfs - ctx->pBase + 1);
+}
+
+void *SFS_ctxWorkOf(SFS_ctx *ctx,SFS_handle handle)
+{
+  struct SFS_tg * sfs;
+
+  sfs = SFS_byHandle(ctx,handle);
+  if(sfs==SFS_NULL)
+    return (void *)0;
+
+  return (void *)sfs->work;
+}
+
+/* Selects how ready tasks are queued.  SFS_POLICY_EDF keeps them in
+   `heap`, a caller-owned array with room for every TCB of the pool,
+   ordered by absolute deadline; SFS_POLICY_ORDER, the default, needs
+   no storage.  Only possible while no task is ready.  Returns 0 or -1. */
+short SFS_ctxPolicy(SFS_ctx *ctx,short policy,struct SFS_tg **heap,unsigned int count)
+{
+  if(ctx->open || ctx->pTask!=SFS_NULL || ctx->heapCount)
+    return -1;
+  if(policy==SFS_POLICY_EDF){
+    if(heap==SFS_NOHEAP || count < ctx->poolSize)
+      return -1;
+  }else if(policy!=SFS_POLICY_ORDER){
+    return -1;
+  }
+
+  ctx->policy = policy;
+  ctx->pHeap = policy==SFS_POLICY_EDF ? heap:SFS_NOHEAP;
+
+  return 0;
+}
+
+/* Relative deadline of a task under SFS_POLICY_EDF.  A ready task is
+   moved to its new place in the heap at once.  Returns -1 if there is
+   no such task. */
+short SFS_ctxDeadline(SFS_ctx *ctx,char *name,unsigned long ticks)
+{
+  struct SFS_tg * sfs;
+
+  sfs = SFS_find(ctx,name);
+  if(sfs==SFS_NULL)
+    return -1;
+
+  sfs->deadline = ticks;
+  if(sfs->slot){
+    SFS_unlink(ctx,sfs);
+    SFS_regist(ctx,sfs);
+  }
+
+  return 0;
+}
+
+/* Takes a task off the ready list (or heap) and the wheel, keeping its
+   TCB and work area, until SFS_ctxResume.  The running task may name
+   itself; it leaves when it returns.  Returns -1 if there is no such
+   task. */
+short SFS_ctxSuspend(SFS_ctx *ctx,char *name)
+{
+  struct SFS_tg * sfs;
+
+  sfs = SFS_find(ctx,name);
+  if(sfs==SFS_NULL)
+    return -1;
+
+  SFS_park(ctx,sfs,SFS_SUSPENDED);
+  return 0;
+}
+
+/* Makes a suspended task ready again, or puts it back on the wheel if
+   it was asleep and its wake tick is still ahead.  Returns -1 if there
+   is no such task. */
+short SFS_ctxResume(SFS_ctx *ctx,char *name)
+{
+  struct SFS_tg * sfs;
+
+  sfs = SFS_find(ctx,name);
+  if(sfs==SFS_NULL)
+    return -1;
+
+  SFS_unpark(ctx,sfs,SFS_SUSPENDED);
+  return 0;
+}
+
+/* Sets the groups a task belongs to, one bit of `mask` per group;
+   0 leaves all of them.  Returns -1 if there is no such task. */
+short SFS_ctxGroup(SFS_ctx *ctx,char *name,unsigned long mask)
+{
+  struct SFS_tg * sfs;
+
+  sfs = SFS_find(ctx,name);
+  if(sfs==SFS_NULL)
+    return -1;
+
+  sfs->group = mask;
+  return 0;
+}
+
+/* Suspends every live task in any of the groups in `mask`.  Walks the
+   pool once.  Returns the number of tasks suspended. */
+unsigned int SFS_ctxSuspendGroup(SFS_ctx *ctx,unsigned long mask)
+{
+  struct SFS_tg * sfs;
+  unsigned int cnt = 0;
+
+  for(sfs=ctx->pBase;sfs<ctx->pBase+ctx->poolSize;sfs++){
+    if(sfs->pFunction!=none && (sfs->group & mask))
+      cnt += SFS_park(ctx,sfs,SFS_SUSPENDED);
+  }
+
+  return cnt;
+}
+
+/* Resumes every suspended task in any of the groups in `mask`.
+   Returns the number of tasks resumed. */
+unsigned int SFS_ctxResumeGroup(SFS_ctx *ctx,unsigned long mask)
+{
+  struct SFS_tg * sfs;
+  unsigned int cnt = 0;
+
+  for(sfs=ctx->pBase;sfs<ctx->pBase+ctx->poolSize;sfs++){
+    if(sfs->pFunction!=none && (sfs->group & mask))
+      cnt += SFS_unpark(ctx,sfs,SFS_SUSPENDED);
+  }
+
+  return cnt;
+}
+
+/* Gives a task a mailbox of `count` (a power of two) message pointers
+   in caller-owned `slot`; 0 slots take it away.  The task is not
+   dispatched while the mailbox is empty, so it starts waiting for its
+   first message.  Returns -1 if there is no such task or `count` is not
+   a power of two. */
+short SFS_ctxMailbox(SFS_ctx *ctx,char *name,void **slot,unsigned int count)
+{
+  struct SFS_tg * sfs;
+
+  sfs = SFS_find(ctx,name);
+  if(sfs==SFS_NULL || (count & (count - 1)) || (count && slot==SFS_NOMAIL))
+    return -1;
+
+  sfs->pMail = count ? slot:SFS_NOMAIL;
+  sfs->mailMask = count - 1;
+  sfs->mailHead = 0;
+  sfs->mailTail = 0;
+  if(count)
+    SFS_park(ctx,sfs,SFS_WAITING);
+  else
+    SFS_unpark(ctx,sfs,SFS_WAITING);
+
+  return 0;
+}
+
+/* Queues the pointer `msg` for a task; the message itself is never
+   copied and stays owned by the sender until the receiver is done
+   with it.  A task waiting for mail becomes ready.  Returns -1 for a
+   stale handle, a task without a mailbox or a full mailbox. */
+short SFS_ctxSend(SFS_ctx *ctx,SFS_handle handle,void *msg)
+{
+  struct SFS_tg * sfs;
+
+  sfs = SFS_byHandle(ctx,handle);
+  if(sfs==SFS_NULL || sfs->pMail==SFS_NOMAIL || (sfs->state & SFS_KILLED))
+    return -1;
+  if(sfs->mailHead - sfs->mailTail > sfs->mailMask)
+    return -1;
+
+  sfs->pMail[sfs->mailHead++ & sfs->mailMask] = msg;
+  SFS_unpark(ctx,sfs,SFS_WAITING);
+
+  return 0;
+}
+
+/* The oldest message of the running task, or NULL once its mailbox is
+   empty; the task then waits, off the queues, until the next one is
+   sent. */
+void *SFS_ctxRecv(SFS_ctx *ctx)
+{
+  struct SFS_tg * exe = ctx->exe;
+
+  if(exe==SFS_NULL || exe->pMail==SFS_NOMAIL)
+    return (void *)0;
+  if(exe->mailHead==exe->mailTail){
+    SFS_park(ctx,exe,SFS_WAITING);
+    return (void *)0;
+  }
+
+  return exe->pMail[exe->mailTail++ & exe->mailMask];
+}
+
+/* Sets flags and makes ready every waiter whose condition now holds.
+   `watched` lets flags nobody waits on return at once, without a look
+   at the waiters; it is rebuilt exactly on each walk.  Returns the
+   number of tasks made ready. */
+unsigned int SFS_ctxSetFlags(SFS_ctx *ctx,SFS_flags *flags,unsigned long bits)
+{
+  struct SFS_tg ** entry;
+  struct SFS_tg * sfs;
+  unsigned long got,watched = 0;
+  unsigned int cnt = 0;
+
+  flags->bits |= bits;
+  if(!(bits & flags->watched))
+    return 0;
+
+  entry = &flags->pWaiter;
+  while((sfs = *entry)!=SFS_NULL){
+    got = flags->bits & sfs->waitMask;
+    if(sfs->waitAll ? got==sfs->waitMask:got!=0){
+      *entry = sfs->pWaiter;
+      sfs->pFlags = SFS_NOFLAGS;
+      SFS_unpark(ctx,sfs,SFS_PENDING);
+      cnt++;
+    }else{
+      watched |= sfs->waitMask;
+      entry = &sfs->pWaiter;
+    }
+  }
+  flags->watched = watched;
+
+  return cnt;
+}
+
+/* For the running task: the flags of `mask` that are set, if any is;
+   otherwise 0, and the task is not dispatched again until one is. */
+unsigned long SFS_ctxWaitAny(SFS_ctx *ctx,SFS_flags *flags,unsigned long mask)
+{
+  return SFS_wait(ctx,flags,mask,0);
+}
+
+/* As SFS_ctxWaitAny, but every flag of `mask` has to be set. */
+unsigned long SFS_ctxWaitAll(SFS_ctx *ctx,SFS_flags *flags,unsigned long mask)
+{
+  return SFS_wait(ctx,flags,mask,1);
+}
+
+/* Makes a sleeping task ready now.  Returns -1 for a stale handle. */
+short SFS_ctxWake(SFS_ctx *ctx,SFS_handle handle)
+{
+  struct SFS_tg * sfs;
+
+  sfs = SFS_byHandle(ctx,handle);
+  if(sfs==SFS_NULL)
+    return -1;
+
+  SFS_wakeup(ctx,sfs);
+  return 0;
+}
+
+/* Requests posted to `queue` are carried out by this instance;
+   SFS_NOQUEUE detaches it. */
+void SFS_ctxListen(SFS_ctx *ctx,SFS_queue *queue)
+{
+  ctx->pQueue = queue;
+}
+
+/* Copies the ready list, in dispatch order, for dispatchers built on
+   top of an instance (see libs/ws).  Under SFS_POLICY_EDF the entries
+   come in heap order, the earliest deadline first.  Returns the number
+   of entries. */
+unsigned int SFS_ctxSnapshot(SFS_ctx *ctx,struct SFS_tg **list,unsigned int max)
+{
+  struct SFS_tg * sfs = ctx->pTask;
+  unsigned int cnt = 0;
+
+  if(ctx->policy==SFS_POLICY_EDF){
+    for(;cnt<ctx->heapCount && cnt<max;cnt++)
+      list[cnt] = ctx->pHeap[cnt];
+    return cnt;
+  }
+
+  while(sfs!=SFS_NULL && cnt<max){
+    list[cnt++] = sfs;
+    sfs = sfs->pBack;
+  }
+
+  return cnt;
+}
+
+/* Releases a task that is not the one currently running. */
+short SFS_ctxRemove(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  if(sfs==SFS_NULL || sfs==ctx->exe)
+    return -1;
+
+  SFS_reap(ctx,sfs);
+
+  return 0;
+}
+
+/*-------------------- static functions --------------------*/
+static struct SFS_tg * SFS_obtain(SFS_ctx *ctx)
+{
+  struct SFS_tg * sfs;
+
+  if(ctx->pPool==SFS_NULL)
+    return SFS_NULL;
+
+  sfs = ctx->pPool;
+  ctx->pPool = sfs->pBack;
+
+  return sfs;
+}
+
+static struct SFS_tg * SFS_spawn(SFS_ctx *ctx,char *name,short order,void (*func)(),unsigned int size)
+{
+  struct SFS_tg * sfs;
+
+  sfs = SFS_prepare(ctx,name,order,func,size);
+  if(sfs!=SFS_NULL)
+    SFS_regist(ctx,sfs);
+dbg_printf(name);
+dbg_printf(" fork !\n");
+  return sfs;
+}
+
+/* Takes a TCB and a work area and fills them in; the caller links the
+   TCB into the ready list. */
+static struct SFS_tg * SFS_prepare(SFS_ctx *ctx,char *name,short order,void (*func)(),unsigned int size)
+{
+  struct SFS_tg * sfs;
+  char * work;
+  unsigned int i;
+#ifdef SFS_STATS
+  unsigned short bin;
+#endif
+
+  sfs = SFS_obtain(ctx);
+  if(sfs!=SFS_NULL){
+    work = SFS_carve(ctx,size);
+    if(work==(char *)0){
+      sfs->pBack = ctx->pPool;
+      ctx->pPool = sfs;
+      sfs = SFS_NULL;
+    }else{
+      sfs->work = work;
+      sfs->workSize = size;
+    }
+  }
+
+  if(sfs!=SFS_NULL){
+#ifdef SFS_STATS
+    sfs->stat.count = 0;
+    sfs->stat.total = 0;
+    sfs->stat.max = 0;
+    for(bin=0;bin<SFS_HIST_BINS;bin++)
+      sfs->stat.hist[bin] = 0;
+#endif
+    strncpy(sfs->name,name,SFS_NAME_SIZE-1);
+    sfs->order = order;
+    sfs->pFunction = func;
+    sfs->pEntry = SFS_NOENTRY;
+    sfs->pArg = (void *)0;
+    sfs->state = 0;
+    sfs->period = 0;
+    sfs->deadline = SFS_NODEADLINE;
+    sfs->group = 0;
+    sfs->pMail = SFS_NOMAIL;
+    sfs->pFlags = SFS_NOFLAGS;
+    sfs->backoff = 0;
+    sfs->ran = ctx->pass - 1;
+    if(ctx->policy==SFS_POLICY_EDF)
+      sfs->wake = SFS_clock(ctx);
+    for(i=0;i<size;i++)
+      sfs->work[i] = 0;
+    SFS_index(ctx,sfs);
+#ifdef SFS_TRACE
+    SFS_record(ctx,sfs,SFS_EV_FORK,SFS_NOW(ctx));
+#endif
+  }
+  return sfs;
+}
+
+/* Inserts behind the tail of its order level, so equal orders keep
+   their fork order.  An empty level is spliced in behind the nearest
+   lower non-empty level found through the bitmaps; no list walk. */
+static void SFS_regist(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  struct SFS_tg * entry;
+  unsigned short level = SFS_LEVEL(sfs->order);
+  short below;
+
+  if(ctx->policy==SFS_POLICY_EDF){
+    /* wake holds the tick the task became ready */
+    sfs->due = sfs->wake + sfs->deadline;
+    SFS_enqueue(ctx,sfs);
+    return;
+  }
+
+  sfs->level = level;
+  entry = ctx->pLast[level];
+
+  if(entry==SFS_NULL){
+    below = SFS_below(ctx,level);
+    SFS_link(ctx,sfs,below < 0 ? SFS_NULL:ctx->pLast[below]);
+    ctx->pLast[level] = sfs;
+    ctx->bmLevel[level/SFS_BITS] |= 1UL << (level%SFS_BITS);
+    ctx->bmWord |= 1UL << (level/SFS_BITS);
+  }else if(level==SFS_LEVEL_TOP){
+    /* orders beyond the bucket range share the top level in sorted order. */
+    while(entry!=SFS_NULL && entry->level==level && sfs->order < entry->order)
+      entry = entry->pFront;
+    SFS_link(ctx,sfs,entry);
+    if(sfs->pFront==ctx->pLast[level])
+      ctx->pLast[level] = sfs;
+  }else{
+    SFS_link(ctx,sfs,entry);
+    ctx->pLast[level] = sfs;
+  }
+}
+
+/* Inserts at the front of its order level, behind the nearest lower
+   non-empty level.  The top level is kept sorted by SFS_regist, and
+   the EDF heap has no levels (pLast stays empty). */
+static void SFS_registFront(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  unsigned short level = SFS_LEVEL(sfs->order);
+  short below;
+
+  if(ctx->pLast[level]==SFS_NULL || level==SFS_LEVEL_TOP){
+    SFS_regist(ctx,sfs);
+    return;
+  }
+
+  sfs->level = level;
+  below = SFS_below(ctx,level);
+  SFS_link(ctx,sfs,below < 0 ? SFS_NULL:ctx->pLast[below]);
+}
+
+/* Inserts sfs behind entry, or at the head when entry is SFS_NULL. */
+static void SFS_link(SFS_ctx *ctx,struct SFS_tg *sfs,struct SFS_tg *entry)
+{
+  sfs->pFront = entry;
+  if(entry==SFS_NULL){
+    sfs->pBack = ctx->pTask;
+    ctx->pTask = sfs;
+  }else{
+    sfs->pBack = entry->pBack;
+    entry->pBack = sfs;
+  }
+  if(sfs->pBack!=SFS_NULL)
+    sfs->pBack->pFront = sfs;
+}
 
-#define HEAD 0
-#define TAIL 7
-#define BODY (TAIL+1)
-#define SFS_NULL ((struct SFS_tg *)0)
+/* Under EDF the running task is already out of the heap, so this
+   is a no-op for it. */
+static void SFS_unlink(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  struct SFS_tg *front_sfs = sfs->pFront;
+  struct SFS_tg *back_sfs = sfs->pBack;
+  unsigned short level = sfs->level;
 
-/*-------------------- public function --------------------*/
-short SFS_initialize(void);
-short SFS_dispatch(void);
-short SFS_fork(char *,short,void (*)());
-void *SFS_work(void);
-void *SFS_otherWork(char *);
-short SFS_kill(void);
-short SFS_change(char *,short,void (*)());
+  if(ctx->policy==SFS_POLICY_EDF){
+    if(sfs->slot)
+      SFS_dequeue(ctx,sfs);
+    return;
+  }
 
-/*-------------------- static function & variable --------------------*/
-static struct SFS_tg SFS[BODY];
-static struct SFS_tg *pTask;
-static struct SFS_tg *pPool;
-static struct SFS_tg *exe;
+  if(ctx->pLast[level]==sfs){
+    if(front_sfs!=SFS_NULL && front_sfs->level==level){
+      ctx->pLast[level] = front_sfs;
+    }else{
+      ctx->pLast[level] = SFS_NULL;
+      ctx->bmLevel[level/SFS_BITS] &= ~(1UL << (level%SFS_BITS));
+      if(!ctx->bmLevel[level/SFS_BITS])
+        ctx->bmWord &= ~(1UL << (level/SFS_BITS));
+    }
+  }
 
-static void none(void){ return; }
-static struct SFS_tg * SFS_obtain(void);
-static void SFS_regist(struct SFS_tg *);
-static void SFS_giveup(void);
-static struct SFS_tg * SFS_find(char *);
-/*------------------------------*/
-static char *strncpy(char *,char *,unsigned int);
-static int strcnt(char *);
-static int strcmp(char *,char *);
+  if(front_sfs==SFS_NULL)
+    ctx->pTask = back_sfs;
+  else
+    front_sfs->pBack = back_sfs;
+  if(back_sfs!=SFS_NULL)
+    back_sfs->pFront = front_sfs;
+}
 
-/*-------------------- public function define --------------------*/
-short SFS_initialize(void)
+static void SFS_enqueue(SFS_ctx *ctx,struct SFS_tg *sfs)
 {
-  short iLoop = 1;
-
-  SFS[HEAD].name[0] = 0x00;
-  SFS[HEAD].order = 0x0000;
-  SFS[HEAD].pFront = SFS_NULL;
-  SFS[HEAD].pBack = &SFS[iLoop];
-  SFS[HEAD].pFunction = none;
-  while(iLoop<TAIL){
-    SFS[iLoop].name[0] = 0x00;
-    SFS[iLoop].order = 0x0000;
-    SFS[iLoop].pFront = &SFS[iLoop-1];
-    SFS[iLoop].pBack = &SFS[iLoop+1];
-    SFS[iLoop].pFunction = none;
-    iLoop++;
-  }
-  SFS[iLoop].name[0] = 0x00;
-  SFS[iLoop].order = 0x0000;
-  SFS[iLoop].pFront = &SFS[iLoop-1];
-  SFS[iLoop].pBack = SFS_NULL;
-  SFS[iLoop].pFunction = none;
-
-  pPool = &SFS[HEAD];
-  pTask = SFS_NULL;
+  ctx->heapCount++;
+  SFS_sift(ctx,sfs,ctx->heapCount);
+}
 
-  return 0;
+/* The last entry of the heap fills the hole left by sfs. */
+static void SFS_dequeue(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  struct SFS_tg * last = ctx->pHeap[--ctx->heapCount];
+  unsigned int slot = sfs->slot;
+
+  sfs->slot = 0;
+  if(last!=sfs)
+    SFS_sift(ctx,last,slot);
 }
 
-short SFS_dispatch(void)
+/* Puts sfs at heap position `slot` (1-based) and moves it up or down
+   until its parent is due no later and its children no earlier. */
+static void SFS_sift(SFS_ctx *ctx,struct SFS_tg *sfs,unsigned int slot)
 {
-  short tcnt=0;
-  static struct SFS_tg * next;
-  
-  exe = pTask;
-  while(exe!=SFS_NULL){
-    next = exe->pBack;
-    (*exe->pFunction)();
-    exe = next;
-    tcnt++;
+  struct SFS_tg ** heap = ctx->pHeap;
+  unsigned int child;
+
+  while(slot > 1 && SFS_before(sfs,heap[slot/2-1])){
+    heap[slot-1] = heap[slot/2-1];
+    heap[slot-1]->slot = slot;
+    slot /= 2;
+  }
+  while((child = slot*2) <= ctx->heapCount){
+    if(child < ctx->heapCount && SFS_before(heap[child],heap[child-1]))
+      child++;
+    if(!SFS_before(heap[child-1],sfs))
+      break;
+    heap[slot-1] = heap[child-1];
+    heap[slot-1]->slot = slot;
+    slot = child;
   }
-  exe = SFS_NULL;
-  
-  return tcnt;
+  heap[slot-1] = sfs;
+  sfs->slot = slot;
 }
 
-short SFS_fork(char *name,short order,void (*func)())
+/* Earlier absolute deadline first; equal deadlines go by order. */
+static int SFS_before(struct SFS_tg *a,struct SFS_tg *b)
 {
-  struct SFS_tg * sfs;
-  short retf = 0;
-  
-  sfs = SFS_obtain();
+  if(a->due!=b->due)
+    return !SFS_NOT_AFTER(b->due,a->due);
+  return a->order < b->order;
+}
 
-  if(sfs!=SFS_NULL){
-    strncpy(sfs->name,name,SFS_NAME_SIZE);
-    sfs->order = order;
-    sfs->pFunction = func;
-    SFS_regist(sfs);
-    retf = -1;
+/* Under EDF a task that ran is ready again from the tick it returned,
+   but waits on pMoved for the end of the pass so that it does not run
+   twice in it. */
+static void SFS_defer(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  sfs->wake = SFS_clock(ctx);
+  sfs->state |= SFS_MOVED;
+  sfs->pBack = ctx->pMoved;
+  ctx->pMoved = sfs;
+}
+
+/* Claims the next slot for a producer.  The slot's sequence equals
+   the position while it is free; a single producer just moves head
+   on, several race for it with the injected compare-and-swap.  A
+   sequence behind the position means the queue is full. */
+static SFS_cmd * SFS_claim(SFS_queue *queue,unsigned long *pos)
+{
+  SFS_cmd * cmd;
+  unsigned long seq;
+
+  for(;;){
+    *pos = queue->head;
+    cmd = &queue->pSlot[*pos & queue->mask];
+    seq = cmd->seq;
+    if(seq==*pos){
+      if(queue->pCas==0){
+        queue->head = *pos + 1;
+        return cmd;
+      }
+      if((*queue->pCas)(&queue->head,*pos,*pos + 1))
+        return cmd;
+    }else if(SFS_NOT_AFTER(seq,*pos)){
+      return SFS_NOCMD;
+    }
   }
-dbg_printf(name);
-dbg_printf(" fork !\n");
-  return retf;
 }
 
-void *SFS_work(void)
+/* Hands a filled slot to the dispatcher. */
+static void SFS_publish(SFS_queue *queue,SFS_cmd *cmd,unsigned long pos)
 {
-  return (void *)exe->work;
+  if(queue->pFence!=0)
+    (*queue->pFence)();
+  cmd->seq = pos + 1;
 }
 
-void *SFS_otherWork(char *name)
+/* Carries out the requests published so far, at most one queue's
+   worth, so producers that keep posting cannot hold up the pass.
+   A slot is free for reuse once its sequence has moved a lap on. */
+static void SFS_drain(SFS_ctx *ctx)
 {
+  SFS_queue * queue = ctx->pQueue;
+  SFS_cmd * cmd;
   struct SFS_tg * sfs;
-  
-  sfs = SFS_find(name);
+  unsigned long pos,n;
 
-  if(sfs==SFS_NULL)
-    return (void *)0;
+  for(n=0;n<=queue->mask;n++){
+    pos = queue->tail;
+    cmd = &queue->pSlot[pos & queue->mask];
+    if(cmd->seq!=pos + 1)
+      break;
+    if(queue->pFence!=0)
+      (*queue->pFence)();
 
-  return (void *)sfs->work;
+    if(cmd->op==SFS_CMD_FORK){
+      if(SFS_spawn(ctx,cmd->name,cmd->order,cmd->pFunction,SFS_WORK_SIZE)==SFS_NULL)
+        queue->failed++;
+    }else if(cmd->op==SFS_CMD_FLAGS){
+      SFS_ctxSetFlags(ctx,cmd->pFlags,cmd->bits);
+    }else{
+      sfs = SFS_byHandle(ctx,cmd->handle);
+      if(sfs==SFS_NULL)
+        queue->failed++;
+      else if(cmd->op==SFS_CMD_KILL)
+        SFS_reap(ctx,sfs);
+      else
+        SFS_wakeup(ctx,sfs);
+    }
+
+    if(queue->pFence!=0)
+      (*queue->pFence)();
+    cmd->seq = pos + queue->mask + 1;
+    queue->tail = pos + 1;
+  }
 }
 
-short SFS_kill(void)
+/* A wait already met returns the flags; otherwise the running task
+   joins the group's waiters and parks when it returns.  A group it
+   waited on earlier in this run is left first, and so is the park.
+   A mask of 0 never waits. */
+static unsigned long SFS_wait(SFS_ctx *ctx,SFS_flags *flags,unsigned long mask,unsigned short all)
 {
-  if(exe!=SFS_NULL){
-    exe->pFunction = SFS_giveup;
+  struct SFS_tg * exe = ctx->exe;
+  unsigned long got = flags->bits & mask;
+
+  if(exe==SFS_NULL || mask==0)
+    return 0;
+  if(exe->pFlags!=SFS_NOFLAGS){
+    SFS_unwait(exe);
+    SFS_unpark(ctx,exe,SFS_PENDING);
   }
-dbg_printf("kill !\n");
+  if(all ? got==mask:got!=0)
+    return got;
+
+  exe->pFlags = flags;
+  exe->waitMask = mask;
+  exe->waitAll = all;
+  exe->pWaiter = flags->pWaiter;
+  flags->pWaiter = exe;
+  flags->watched |= mask;
+  SFS_park(ctx,exe,SFS_PENDING);
+
   return 0;
 }
 
-short SFS_change(char *name,short order,void (*func)())
+/* Leaves the waiters of a group.  `watched` may keep the task's bits
+   until the next SFS_ctxSetFlags walk rebuilds it. */
+static void SFS_unwait(struct SFS_tg *sfs)
 {
-  if(exe!=SFS_NULL){
-    strncpy(exe->name,name,SFS_NAME_SIZE);
-    exe->order = order;
-    exe->pFunction = func;
+  struct SFS_tg ** entry;
+
+  for(entry=&sfs->pFlags->pWaiter;*entry!=sfs;entry=&(*entry)->pWaiter)
+    ;
+  *entry = sfs->pWaiter;
+  sfs->pFlags = SFS_NOFLAGS;
+}
+
+/* Off the wheel and onto the ready list.  The task counts as ready
+   from this tick (for EDF), and a periodic one restarts its period
+   here.  A backed-off task rejoins the passes with its back-off reset.
+   A task that is neither is left alone. */
+static void SFS_wakeup(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  if((sfs->state & (SFS_NAPPING|SFS_KILLED))==SFS_NAPPING){
+    if(sfs!=ctx->exe)
+      SFS_unnap(ctx,sfs);
+    sfs->backoff = 0;
+    SFS_unpark(ctx,sfs,SFS_NAPPING);
+    return;
   }
-dbg_printf("change !!\n");
-  return 0;
+  if(!(sfs->state & SFS_TIMED))
+    return;
+
+  SFS_disarm(ctx,sfs);
+  sfs->wake = ctx->now;
+  SFS_ready(ctx,sfs);
 }
 
-/*-------------------- static functions --------------------*/
-static struct SFS_tg * SFS_obtain(void)
+/* The running task reported idle and has left the queues: it waits on
+   the pNap slot of the pass it rejoins, `backoff` passes after this
+   one.  The slot holds no other pass, as the back-off never exceeds
+   the number of slots; `level` remembers it. */
+static void SFS_nap(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  unsigned short slot = (ctx->pass + sfs->backoff) & (SFS_BACKOFF_MAX-1);
+
+  sfs->level = slot;
+  sfs->pFront = SFS_NULL;
+  sfs->pBack = ctx->pNap[slot];
+  if(sfs->pBack!=SFS_NULL)
+    sfs->pBack->pFront = sfs;
+  ctx->pNap[slot] = sfs;
+  ctx->napping++;
+}
+
+/* Takes a backed-off task off its pNap slot, leaving SFS_NAPPING to
+   the caller. */
+static void SFS_unnap(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  if(sfs->pFront==SFS_NULL)
+    ctx->pNap[sfs->level] = sfs->pBack;
+  else
+    sfs->pFront->pBack = sfs->pBack;
+  if(sfs->pBack!=SFS_NULL)
+    sfs->pBack->pFront = sfs->pFront;
+  ctx->napping--;
+}
+
+/* Start of a pass: the tasks whose back-off ends here rejoin the
+   queues, unless something else (a suspension) still holds them. */
+static void SFS_rouse(SFS_ctx *ctx)
 {
+  unsigned short slot = ctx->pass & (SFS_BACKOFF_MAX-1);
   struct SFS_tg * sfs;
-  
-  if(pPool==SFS_NULL)
-    return SFS_NULL;
 
-  sfs = pPool;
-  pPool = pPool->pBack;
+  while((sfs = ctx->pNap[slot])!=SFS_NULL){
+    SFS_unnap(ctx,sfs);
+    SFS_unpark(ctx,sfs,SFS_NAPPING);
+  }
+}
 
-  return sfs;
+/* Passes until the first backed-off task rejoins: 1 if it does at
+   the next one. */
+static unsigned short SFS_nextNap(SFS_ctx *ctx)
+{
+  unsigned short d;
+
+  for(d=1;d<SFS_BACKOFF_MAX;d++)
+    if(ctx->pNap[(ctx->pass + d) & (SFS_BACKOFF_MAX-1)]!=SFS_NULL)
+      break;
+
+  return d;
 }
 
-static void SFS_regist(struct SFS_tg *sfs)
+static unsigned long SFS_clock(SFS_ctx *ctx)
 {
-  struct SFS_tg * entry;
-  short order = sfs->order;
-/*  short flag = 1; */
-  
-  if(pTask==SFS_NULL){
-    pTask = sfs;
-    sfs->pBack = SFS_NULL;
-  }else{
-    entry = pTask;
-    while(entry->pBack!=SFS_NULL){
-      if(order < entry->order){
-        break;
-      }else if(order >= entry->order){
-        if(order < entry->pBack->order){
-          break;
+  return ctx->pTimer!=SFS_NOTIMER ? (*ctx->pTimer)():ctx->now;
+}
+
+/* Highest non-empty level below the given one, or -1. */
+static short SFS_below(SFS_ctx *ctx,unsigned short level)
+{
+  short word = level/SFS_BITS;
+  unsigned long bits;
+
+  bits = ctx->bmLevel[word] & ((1UL << (level%SFS_BITS)) - 1);
+  if(bits)
+    return word*SFS_BITS + SFS_fls(bits);
+
+  bits = ctx->bmWord & ((1UL << word) - 1);
+  if(!bits)
+    return -1;
+  word = SFS_fls(bits);
+
+  return word*SFS_BITS + SFS_fls(ctx->bmLevel[word]);
+}
+
+/* Index of the highest set bit of a non-zero 32 bit word. */
+static short SFS_fls(unsigned long bits)
+{
+  short n = 0;
+
+  if(bits & 0xFFFF0000UL){ n += 16; bits >>= 16; }
+  if(bits & 0x0000FF00UL){ n += 8; bits >>= 8; }
+  if(bits & 0x000000F0UL){ n += 4; bits >>= 4; }
+  if(bits & 0x0000000CUL){ n += 2; bits >>= 2; }
+  if(bits & 0x00000002UL){ n += 1; }
+
+  return n;
+}
+
+/* One pass, or the rest of one cut short by a budget.  A task that
+   kills itself leaves the list as soon as it returns, in the same pass;
+   it still counts as executed.  Killed TCBs are handed back to the pool
+   at the end of the pass, so their names, handles and work areas stay
+   valid until then.  Sleeping and backed-off tasks are added to the
+   count, so `while(SFS_dispatch());` runs until every task has been
+   killed.
+   pNext is the only cursor into the list, and the resume point of a
+   pass cut short: whatever removes the task due next moves it on (see
+   SFS_drop).  Under EDF there is no cursor: each task is taken out of
+   the heap when it runs and held on pMoved until the pass is over, so
+   the heap only holds the tasks still to run. */
+static short SFS_run(SFS_ctx *ctx,int bounded,unsigned long budget)
+{
+  long tcnt;
+  struct SFS_tg * exe;
+  unsigned long begin = 0;
+  unsigned long used = 0;
+  unsigned long slept;
+  unsigned short nap;
+#ifdef SFS_STATS
+  unsigned long start;
+#endif
+#ifdef SFS_TRACE
+  unsigned long mark;
+#endif
+
+  if(!ctx->open){
+    if(ctx->pTimer!=SFS_NOTIMER)
+      SFS_advance(ctx);
+    if(ctx->pQueue!=SFS_NOQUEUE)
+      SFS_drain(ctx);
+    ctx->pass++;
+    if(ctx->napping)
+      SFS_rouse(ctx);
+    if(ctx->pTask==SFS_NULL && ctx->heapCount==0 && ctx->pIdle!=SFS_NOIDLE){
+      (*ctx->pIdle)(SFS_ctxNext(ctx));
+      /* the ticks slept were empty passes to the backed-off tasks */
+      if(ctx->napping && ctx->pTimer!=SFS_NOTIMER){
+        slept = (*ctx->pTimer)() - ctx->now;
+        while(ctx->napping && (nap = SFS_nextNap(ctx))<=slept){
+          ctx->pass += nap;
+          slept -= nap;
+          SFS_rouse(ctx);
         }
       }
-      entry = entry->pBack;
     }
-    if(order < entry->order){         /* befor.. */
-      if(entry->pFront == SFS_NULL){  /* inserts in the head. */
-        pTask = sfs;
-        sfs->pFront = SFS_NULL;
-        sfs->pBack = entry;
-        entry->pFront = sfs;
-      }else{                          /* inserts in the entry point front of a main part. */
-        sfs->pFront = entry->pFront;
-        sfs->pBack = entry;
-        entry->pFront = sfs;
-      }
-    }else{                            /* to back.. */
-      if(entry->pBack == SFS_NULL){   /* inserts in a tail. */
-        entry->pBack = sfs;
-        sfs->pBack = SFS_NULL;
-      }else{                          /* inserts behind the entry point of a main part. */
-        sfs->pBack = entry->pBack;
-        sfs->pFront = entry;
-        entry->pBack = sfs;
+    ctx->pNext = ctx->pTask;
+    ctx->ran = 0;
+    ctx->open = 1;
+  }
+  if(bounded && ctx->pTimer!=SFS_NOTIMER)
+    begin = (*ctx->pTimer)();
+
+  exe = ctx->policy==SFS_POLICY_EDF ? SFS_EARLIEST(ctx):ctx->pNext;
+  while(exe!=SFS_NULL){
+    ctx->exe = exe;
+    if(ctx->policy==SFS_POLICY_EDF)
+      SFS_dequeue(ctx,exe);
+    else
+      ctx->pNext = exe->pBack;
+    exe->ran = ctx->pass;
+#ifdef SFS_STATS
+    start = ctx->pProbe!=SFS_NOTIMER ? (*ctx->pProbe)():0;
+#endif
+#ifdef SFS_TRACE
+    mark = SFS_NOW(ctx);
+#endif
+    if(exe->pEntry!=SFS_NOENTRY)
+      (*exe->pEntry)(exe->pArg);
+    else
+      (*exe->pFunction)();
+#ifdef SFS_STATS
+    SFS_account(ctx,exe,start);
+#endif
+#ifdef SFS_TRACE
+    SFS_record(ctx,exe,SFS_EV_DISPATCH,mark);
+#endif
+    if(exe->state){
+      if(exe->state & SFS_KILLED){
+        SFS_drop(ctx,exe);
+      }else{
+        if(exe->state & SFS_MOVED)
+          SFS_move(ctx,exe);
+        SFS_settle(ctx,exe);
+        if(exe->state & SFS_OFF)
+          SFS_detach(ctx,exe);
+        if((exe->state & SFS_OFF)==SFS_NAPPING)
+          SFS_nap(ctx,exe);
+        else
+          exe->state &= ~SFS_NAPPING;
       }
     }
+    if(ctx->policy==SFS_POLICY_EDF){
+      if(!(exe->state & (SFS_KILLED|SFS_TIMED|SFS_MOVED|SFS_OFF)))
+        SFS_defer(ctx,exe);
+      exe = SFS_EARLIEST(ctx);
+    }else{
+      exe = ctx->pNext;
+    }
+    ctx->ran++;
+    if(bounded && exe!=SFS_NULL){
+      used = ctx->pTimer!=SFS_NOTIMER ? (*ctx->pTimer)()-begin:used+1;
+      if(used >= budget)
+        break;
+    }
+  }
+  ctx->exe = SFS_NULL;
+  if(exe!=SFS_NULL)
+    return -1;
+
+  ctx->open = 0;
+  while(ctx->pMoved!=SFS_NULL){
+    exe = ctx->pMoved;
+    ctx->pMoved = exe->pBack;
+    exe->state &= ~SFS_MOVED;
+    SFS_registFront(ctx,exe);
   }
+  while(ctx->pReap!=SFS_NULL){
+    exe = ctx->pReap;
+    ctx->pReap = exe->pBack;
+    SFS_unindex(exe);
+    SFS_release(ctx,exe);
+  }
+  tcnt = ctx->ran + ctx->timed + ctx->napping;
+
+  return tcnt > SFS_SHORT_MAX ? SFS_SHORT_MAX:(short)tcnt;
 }
 
-static void SFS_release(struct SFS_tg *sfs)
+static void SFS_release(SFS_ctx *ctx,struct SFS_tg *sfs)
 {
-  struct SFS_tg * entry;
+  sfs->gen = (sfs->gen + 1) & SFS_GEN_MASK;
+  sfs->pFunction = none;
+  SFS_uncarve(ctx,sfs->work);
+  sfs->pFront = SFS_NULL;
+  sfs->pBack = ctx->pPool;
+  ctx->pPool = sfs;
+}
 
-  if(pPool==SFS_NULL){
-    pPool = sfs;
-    sfs->pFront = SFS_NULL;
-    sfs->pBack = SFS_NULL;
+/* Kills a task once.  The running task is only marked; the dispatcher
+   drops it when it returns. */
+static void SFS_reap(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  if(sfs->state & SFS_KILLED)
+    return;
+
+  sfs->state |= SFS_KILLED;
+  if(sfs!=ctx->exe)
+    SFS_drop(ctx,sfs);
+}
+
+/* Takes a killed task off the ready list or the wheel.  Outside a pass
+   it is released at once; during one, including between the calls of a
+   pass cut short by a budget, it waits on pReap for the end of the
+   pass.  If it is the next one due, the cursor moves past it, so
+   the dispatch loop never follows a TCB that has left the list. */
+static void SFS_drop(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+#ifdef SFS_TRACE
+  SFS_record(ctx,sfs,SFS_EV_KILL,SFS_NOW(ctx));
+#endif
+  if(sfs->pFlags!=SFS_NOFLAGS)
+    SFS_unwait(sfs);
+  if((sfs->state & SFS_NAPPING) && sfs!=ctx->exe)
+    SFS_unnap(ctx,sfs);
+  if(!ctx->open){
+    SFS_discard(ctx,sfs);
+    return;
+  }
+
+  if(!SFS_PARKED(ctx,sfs))
+    SFS_detach(ctx,sfs);
+  sfs->pBack = ctx->pReap;
+  ctx->pReap = sfs;
+}
+
+/* Takes a task off whatever holds it: the wheel, pMoved or the ready
+   list (or heap).  If it is the next one due, the cursor moves past
+   it first. */
+static void SFS_detach(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  struct SFS_tg ** entry;
+
+  if(sfs==ctx->pNext)
+    ctx->pNext = sfs->pBack;
+  if(sfs->state & SFS_TIMED){
+    SFS_disarm(ctx,sfs);
+  }else if((sfs->state & SFS_MOVED) && sfs!=ctx->exe){
+    /* waiting on pMoved, which only holds the tasks moved this pass */
+    for(entry=&ctx->pMoved;*entry!=sfs;entry=&(*entry)->pBack)
+      ;
+    *entry = sfs->pBack;
   }else{
-    entry = pPool;
-    while(entry->pBack!=SFS_NULL){
-      entry = entry->pBack;
-    }
-    entry->pBack = sfs;
-    sfs->pBack = SFS_NULL;
+    SFS_unlink(ctx,sfs);
+  }
+}
+
+/* Sets one reason (one of the SFS_OFF bits) for a task to stay off
+   the queues; the first one takes it off.  A sleeping one remembers,
+   through SFS_DOZE, that it resumes on the wheel.  Any other reason
+   ends a back-off, which only runs while nothing else holds the task.
+   The running task is only marked; the dispatcher detaches it when it
+   returns.  Returns 1 if the reason was set now. */
+static short SFS_park(SFS_ctx *ctx,struct SFS_tg *sfs,unsigned short why)
+{
+  if(sfs->state & (SFS_KILLED|why))
+    return 0;
+
+  if(sfs!=ctx->exe && !(sfs->state & SFS_OFF)){
+    if(sfs->state & SFS_TIMED)
+      sfs->state |= SFS_DOZE;
+    SFS_detach(ctx,sfs);
+    sfs->state &= ~SFS_MOVED;
+  }else if(sfs!=ctx->exe && (sfs->state & SFS_NAPPING)){
+    SFS_unnap(ctx,sfs);
+    sfs->state &= ~SFS_NAPPING;
   }
+  sfs->state |= why;
+
+  return 1;
 }
 
-static void SFS_giveup(void)
+/* Clears one reason; once none is left the task is back onto the wheel
+   if it was asleep and its wake tick is still ahead, otherwise ready
+   from this tick, like a task woken by SFS_wakeup.  Landing just in
+   front of the dispatch cursor, it is still due in this pass, so a
+   message sent to a later task is handled in the same pass, unless it
+   already ran in it (SFS_ready).  The running task never left.
+   Returns 1 if the reason was cleared now. */
+static short SFS_unpark(SFS_ctx *ctx,struct SFS_tg *sfs,unsigned short why)
 {
-  struct SFS_tg *front_sfs = exe->pFront;
-  struct SFS_tg *back_sfs = exe->pBack;
+  if((sfs->state & (SFS_KILLED|why))!=why)
+    return 0;
+
+  sfs->state &= ~why;
+  if(sfs==ctx->exe || (sfs->state & SFS_OFF))
+    return 1;
+
+  if(sfs->state & SFS_DOZE){
+    sfs->state &= ~SFS_DOZE;
+    if(!SFS_NOT_AFTER(sfs->wake,ctx->now)){
+      SFS_arm(ctx,sfs);
+      return 1;
+    }
+  }
+  sfs->wake = ctx->now;
+  if(SFS_ready(ctx,sfs) && ctx->open && ctx->policy==SFS_POLICY_ORDER && sfs->pBack==ctx->pNext)
+    ctx->pNext = sfs;
+
+  return 1;
+}
 
-  if(front_sfs==SFS_NULL){
-    if(back_sfs==SFS_NULL){
-      pTask = SFS_NULL;
+/* Back onto the ready list (or heap).  A task that already ran in this
+   pass, and was taken off and put back since, waits for the end of the
+   pass on pMoved instead, as a task moved down does (or deferred, under
+   EDF), so that it does not run twice in it.  Returns 0 in that case. */
+static short SFS_ready(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  if(ctx->open && sfs->ran==ctx->pass){
+    if(ctx->policy==SFS_POLICY_EDF){
+      SFS_defer(ctx,sfs);
     }else{
-      back_sfs->pFront = SFS_NULL;
-      pTask = back_sfs;
+      sfs->state |= SFS_MOVED;
+      sfs->pBack = ctx->pMoved;
+      ctx->pMoved = sfs;
     }
-    SFS_release(exe);
-  }else if(back_sfs==SFS_NULL){
-    front_sfs->pBack = SFS_NULL;
-    SFS_release(exe);
+    return 0;
+  }
+  SFS_regist(ctx,sfs);
+
+  return 1;
+}
+
+/* The running task changed its order and has returned.  A task moving
+   up joins the back of its new level, which is in front of the dispatch
+   cursor, so it is re-registered now.  One moving down could be met
+   again in this pass, so it waits on pMoved and joins the front of its
+   new level when the pass is over.  Either way it keeps as close to its
+   old place as the sort allows.  A timed task is left to SFS_settle,
+   and wakes up into its new level.  Under EDF the order only breaks
+   ties, and the task goes back to the heap through SFS_defer.  The new
+   order is only taken here: until then the task is linked by the old
+   one, which the sorted top level is walked by. */
+static void SFS_move(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  sfs->order = sfs->reorder;
+  sfs->state &= ~SFS_MOVED;
+  if((sfs->state & (SFS_DOZE|SFS_PERIODIC|SFS_OFF)) || ctx->policy==SFS_POLICY_EDF)
+    return;
+
+  SFS_unlink(ctx,sfs);
+  if(SFS_LEVEL(sfs->order) < sfs->level){
+    SFS_regist(ctx,sfs);
   }else{
-    front_sfs->pBack = back_sfs;
-    back_sfs->pFront = front_sfs;
-    SFS_release(exe);
+    sfs->state |= SFS_MOVED;
+    sfs->pBack = ctx->pMoved;
+    ctx->pMoved = sfs;
   }
-dbg_printf("give up !\n");
 }
 
-static struct SFS_tg * SFS_find(char *name)
+/* The live TCB a handle refers to, or SFS_NULL once it was released. */
+static struct SFS_tg * SFS_byHandle(SFS_ctx *ctx,SFS_handle handle)
 {
+  unsigned long index = (handle & SFS_INDEX_MASK) - 1;
   struct SFS_tg * sfs;
-  
-  if(pTask==SFS_NULL)
+
+  if(index >= ctx->poolSize)
     return SFS_NULL;
-  
-  sfs = pTask;
-  
+
+  sfs = &ctx->pBase[index];
+  if(sfs->gen != (handle >> SFS_INDEX_BITS))
+    return SFS_NULL;
+
+  return sfs;
+}
+
+static void SFS_discard(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  if(!SFS_PARKED(ctx,sfs))
+    SFS_detach(ctx,sfs);
+  SFS_unindex(sfs);
+  SFS_release(ctx,sfs);
+dbg_printf("give up !\n");
+}
+
+/* SFS_index pushes at the head of the bucket, so of the tasks sharing
+   a name the one forked, or renamed by SFS_ctxChange, last is found. */
+static struct SFS_tg * SFS_find(SFS_ctx *ctx,char *name)
+{
+  struct SFS_tg * sfs;
+
+  sfs = ctx->pName[SFS_hash(name) & ctx->nameMask];
+
   while(sfs!=SFS_NULL){
-    if(!strcmp(sfs->name,name))
+    if(!strncmp(sfs->name,name,SFS_NAME_SIZE-1))
       break;
-    sfs = sfs->pBack;
+    sfs = sfs->pHash;
   }
-  
+
   return sfs;
 }
 
+/* Each TCB keeps the address of the link pointing at it, so taking it
+   off its bucket needs neither the hash nor a walk of the chain. */
+static void SFS_index(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  struct SFS_tg ** entry = &ctx->pName[SFS_hash(sfs->name) & ctx->nameMask];
+
+  sfs->pHash = *entry;
+  if(sfs->pHash!=SFS_NULL)
+    sfs->pHash->ppHash = &sfs->pHash;
+  sfs->ppHash = entry;
+  *entry = sfs;
+}
+
+static void SFS_unindex(struct SFS_tg *sfs)
+{
+  if(sfs->ppHash==(struct SFS_tg **)0)
+    return;
+
+  *sfs->ppHash = sfs->pHash;
+  if(sfs->pHash!=SFS_NULL)
+    sfs->pHash->ppHash = sfs->ppHash;
+  sfs->ppHash = (struct SFS_tg **)0;
+}
+
+static unsigned int SFS_hash(char *name)
+{
+  unsigned int key = 0;
+  unsigned int n = SFS_NAME_SIZE-1;
+
+  while(n-- && *name)
+    key = key * 31 + (unsigned char)*name++;
+
+  return key;
+}
+
+/* Handles every tick up to the timer's value.  When the lowest levels
+   are empty, the ticks up to the next boundary where an upper slot
+   cascades are skipped in one step. */
+static void SFS_advance(SFS_ctx *ctx)
+{
+  unsigned long now = (*ctx->pTimer)();
+  unsigned long mask;
+  unsigned short level;
+
+  ctx->now = now;
+  while(SFS_NOT_AFTER(ctx->tick,now)){
+    for(level=0;level<SFS_WHEEL_LEVELS && !ctx->bmWheel[level];level++);
+    if(level==SFS_WHEEL_LEVELS)
+      break;
+    mask = (1UL << (level*SFS_WHEEL_BITS)) - 1;
+    if(ctx->tick & mask){
+      if(!SFS_NOT_AFTER((ctx->tick | mask) + 1,now))
+        break;
+      ctx->tick = (ctx->tick | mask) + 1;
+    }
+    SFS_expire(ctx);
+  }
+  if(SFS_NOT_AFTER(ctx->tick,now))
+    ctx->tick = now + 1;
+}
+
+/* One tick: on a slot boundary the matching upper slots cascade down
+   a level, then the level 0 slot of the tick becomes ready. */
+static void SFS_expire(SFS_ctx *ctx)
+{
+  unsigned long tick = ctx->tick;
+  unsigned short level,slot;
+  struct SFS_tg * sfs;
+
+  for(level=1;level<SFS_WHEEL_LEVELS;level++){
+    if(tick & ((1UL << (level*SFS_WHEEL_BITS)) - 1))
+      break;
+    slot = (tick >> (level*SFS_WHEEL_BITS)) & SFS_WHEEL_MASK;
+    while((sfs = ctx->pWheel[level][slot])!=SFS_NULL){
+      SFS_disarm(ctx,sfs);
+      SFS_arm(ctx,sfs);
+    }
+  }
+
+  slot = tick & SFS_WHEEL_MASK;
+  while((sfs = ctx->pWheel[0][slot])!=SFS_NULL){
+    SFS_disarm(ctx,sfs);
+    SFS_regist(ctx,sfs);
+  }
+  ctx->tick = tick + 1;
+}
+
+/* After a timed task ran: off the ready list and onto the wheel. */
+static void SFS_settle(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  if(sfs->state & SFS_DOZE){
+    sfs->state &= ~SFS_DOZE;
+  }else if(sfs->state & SFS_PERIODIC){
+    sfs->wake += sfs->period;
+    if(SFS_NOT_AFTER(sfs->wake,ctx->now))  /* overrun: skip the missed runs */
+      sfs->wake = ctx->now + sfs->period;
+  }else{
+    return;
+  }
+  if(sfs->state & SFS_OFF){   /* resumes onto the wheel */
+    sfs->state |= SFS_DOZE;
+    return;
+  }
+
+  SFS_unlink(ctx,sfs);
+  SFS_arm(ctx,sfs);
+}
+
+/* Hangs a task in the lowest level whose span covers its delay.
+   Delays beyond the wheel go to the last slot in reach and are
+   re-armed from there. */
+static void SFS_arm(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  unsigned long when = sfs->wake;
+  unsigned long delta = when - ctx->tick;
+  unsigned short level = 0;
+  unsigned short slot;
+
+  if(delta > SFS_LONG_HALF){
+    when = ctx->tick;
+    delta = 0;
+  }else if(delta >= SFS_WHEEL_SPAN){
+    delta = SFS_WHEEL_SPAN - 1;
+    when = ctx->tick + delta;
+  }
+  while(delta >= SFS_WHEEL_SLOTS){
+    delta >>= SFS_WHEEL_BITS;
+    level++;
+  }
+  slot = (when >> (level*SFS_WHEEL_BITS)) & SFS_WHEEL_MASK;
+
+  sfs->level = level*SFS_WHEEL_SLOTS + slot;
+  sfs->state |= SFS_TIMED;
+  sfs->pFront = SFS_NULL;
+  sfs->pBack = ctx->pWheel[level][slot];
+  if(sfs->pBack!=SFS_NULL)
+    sfs->pBack->pFront = sfs;
+  ctx->pWheel[level][slot] = sfs;
+  ctx->bmWheel[level] |= 1UL << slot;
+  ctx->timed++;
+}
+
+#ifdef SFS_STATS
+static void SFS_account(SFS_ctx *ctx,struct SFS_tg *sfs,unsigned long start)
+{
+  unsigned long span = 0;
+  unsigned short bin = 0;
+
+  if(ctx->pProbe!=SFS_NOTIMER)
+    span = (*ctx->pProbe)() - start;
+  if(span > 0xFFFFFFFFUL)
+    bin = SFS_HIST_BINS-1;
+  else if(span)
+    bin = SFS_fls(span) + 1;
+  if(bin > SFS_HIST_BINS-1)
+    bin = SFS_HIST_BINS-1;
+
+  sfs->stat.count++;
+  sfs->stat.total += span;
+  if(span > sfs->stat.max)
+    sfs->stat.max = span;
+  sfs->stat.hist[bin]++;
+}
+#endif
+
+#ifdef SFS_TRACE
+/* One record from `start` to now.  No formatting and no branch on a
+   full ring: the head just runs on over the oldest entry. */
+static void SFS_record(SFS_ctx *ctx,struct SFS_tg *sfs,unsigned short type,unsigned long start)
+{
+  SFS_event * ev;
+
+  if(ctx->pRing==(SFS_event *)0)
+    return;
+
+  ev = &ctx->pRing[ctx->ringHead++ & ctx->ringMask];
+  ev->start = start;
+  ev->end = type==SFS_EV_DISPATCH ? SFS_NOW(ctx):start;
+  ev->task = (unsigned int)(sfs - ctx->pBase);
+  ev->type = type;
+}
+#endif
+
+/* Work areas: a released area of the same size is reused first,
+   otherwise the arena is bumped.  Areas are never split or merged,
+   which suits tasks that are forked again with the sizes they had.
+   The header in front of each area keeps its size, so the contents
+   survive the release until the area is handed out again. */
+static char * SFS_carve(SFS_ctx *ctx,unsigned int size)
+{
+  SFS_blk ** entry = &ctx->pFree;
+  SFS_blk * blk;
+  unsigned long need = SFS_AREA(size);
+
+  while(*entry!=SFS_BLK_NULL){
+    blk = *entry;
+    if(blk->size==need){
+      *entry = blk->pNext;
+      return (char *)(blk+1);
+    }
+    entry = &blk->pNext;
+  }
+
+  if((unsigned long)(ctx->pEnd - ctx->pTop) < need)
+    return (char *)0;
+  blk = (SFS_blk *)ctx->pTop;
+  blk->size = need;
+  ctx->pTop += need;
+
+  return (char *)(blk+1);
+}
+
+static void SFS_uncarve(SFS_ctx *ctx,char *work)
+{
+  SFS_blk * blk = (SFS_blk *)work - 1;
+
+  if(work==(char *)0)
+    return;
+
+  blk->pNext = ctx->pFree;
+  ctx->pFree = blk;
+}
+
+/* Index of the lowest set bit of a non-zero word. */
+static short SFS_ffs(unsigned long bits)
+{
+  return SFS_fls(bits & (0UL - bits));
+}
+
+static void SFS_disarm(SFS_ctx *ctx,struct SFS_tg *sfs)
+{
+  unsigned short level = sfs->level / SFS_WHEEL_SLOTS;
+  unsigned short slot = sfs->level % SFS_WHEEL_SLOTS;
+
+  if(sfs->pFront==SFS_NULL)
+    ctx->pWheel[level][slot] = sfs->pBack;
+  else
+    sfs->pFront->pBack = sfs->pBack;
+  if(sfs->pBack!=SFS_NULL)
+    sfs->pBack->pFront = sfs->pFront;
+  if(ctx->pWheel[level][slot]==SFS_NULL)
+    ctx->bmWheel[level] &= ~(1UL << slot);
+  sfs->state &= ~SFS_TIMED;
+  ctx->timed--;
+}
+
 /*------------------------------*/
 
 static char *strncpy(char *s1,char *s2,unsigned int n)
@@ -295,18 +2466,15 @@ static int strcnt(char *s)
   return cnt;
 }
 
-static int strcmp(char *s1,char *s2)
+static int strncmp(char *s1,char *s2,unsigned int n)
 {
-  int retf;
-  
-  while( *s1 && *s1 == *s2 ){
+  while( n && *s1 && *s1 == *s2 ){
     s1++;
     s2++;
+    n--;
   }
-  
-  retf = *s1 - *s2;
-  
-  return retf;
+
+  return n ? *s1 - *s2:0;
 }
 
 /* ----[EOF]---- */
@@ -7,17 +7,288 @@
 #define __SFS_INC__
 
 #define SFS_NAME_SIZE 16
+/* Work area size given to tasks forked by SFS_fork(); SFS_forkSize()
+   chooses it per task.  Work areas are carved from an arena. */
 #define SFS_WORK_SIZE 32
-/* Task Control Block */
+/* Arena storage for `count` work areas of `size` bytes:
+     static SFS_ARENA(arena, 100, SFS_WORK_SIZE);
+     SFS_arena(arena, sizeof(arena));
+   Every area is preceded by a small header (SFS_blk). */
+typedef union SFS_align_tg {
+  long l;
+  void *p;
+} SFS_align;
+typedef struct SFS_blk_tg {
+  struct SFS_blk_tg *pNext;     /* free list link while released */
+  unsigned long size;
+} SFS_blk;
+#define SFS_AREA(size) (sizeof(SFS_blk) + ((size)+sizeof(SFS_align)-1)/sizeof(SFS_align)*sizeof(SFS_align))
+#define SFS_ARENA(name,count,size) SFS_align name[(count)*SFS_AREA(size)/sizeof(SFS_align)]
+/* Size of the built-in pool used by SFS_initialize().
+   Override at build time (-DSFS_TASK_MAX=n) or hand a caller-owned
+   array to SFS_initializePool() instead.  A handle holds the TCB index
+   in 20 bits, so a pool has at most 1,048,575 TCBs; a larger count is
+   refused with -1. */
+#ifndef SFS_TASK_MAX
+#define SFS_TASK_MAX 8
+#endif
+/* Number of run queue buckets (1..1024).  Orders 0..SFS_ORDER_LEVELS-2
+   get a bucket each; larger orders share the last bucket, which is kept
+   sorted by a short walk inside that bucket only. */
+#ifndef SFS_ORDER_LEVELS
+#define SFS_ORDER_LEVELS 64
+#endif
+/* Buckets of the built-in task name index (power of two).  A large
+   pool hands a bigger table to SFS_names() instead. */
+#ifndef SFS_HASH_SIZE
+#define SFS_HASH_SIZE 32
+#endif
+#if SFS_HASH_SIZE < 1 || (SFS_HASH_SIZE & (SFS_HASH_SIZE-1))
+#error "SFS_HASH_SIZE must be a power of two"
+#endif
+/* Stable reference to a task, see SFS_lookup(). */
+typedef unsigned long SFS_handle;
+#define SFS_NOHANDLE ((SFS_handle)0)
+/* Trailing guard so neighbouring scheduler instances do not share a
+   cache line; set to 0 on targets without a data cache. */
+#ifndef SFS_CACHE_LINE
+#define SFS_CACHE_LINE 64
+#endif
+#define SFS_BITS 32
+#define SFS_LEVEL_WORDS ((SFS_ORDER_LEVELS+SFS_BITS-1)/SFS_BITS)
+/* Timing wheel for SFS_sleep()/SFS_forkPeriodic(): SFS_WHEEL_LEVELS
+   levels of 32 slots each cover 32^levels ticks; longer delays are
+   re-cascaded until they fit. */
+#ifndef SFS_WHEEL_LEVELS
+#define SFS_WHEEL_LEVELS 4
+#endif
+#define SFS_WHEEL_BITS 5
+#define SFS_WHEEL_SLOTS (1 << SFS_WHEEL_BITS)
+/* SFS_next() when no task is waiting on the wheel */
+#define SFS_FOREVER (~0UL)
+/* Ready queue policies, see SFS_policy().  SFS_POLICY_ORDER runs the
+   tasks by `order`; SFS_POLICY_EDF by absolute deadline, the tick a
+   task became ready plus its relative deadline (SFS_deadline()).
+   Tasks without a deadline run after those that have one. */
+#define SFS_POLICY_ORDER 0
+#define SFS_POLICY_EDF 1
+#define SFS_NODEADLINE (~0UL >> 2)
+/* Activity hints for SFS_report().  A poller that found nothing to do
+   reports SFS_IDLE and sits out the next passes: it runs every 2nd
+   pass, then every 4th and so on up to every SFS_BACKOFF_MAX-th while
+   it stays idle.  SFS_BUSY, or SFS_wake(), puts it back on every pass. */
+#define SFS_BUSY 0
+#define SFS_IDLE 1
+/* Longest back-off in passes; a power of two, at least 2. */
+#ifndef SFS_BACKOFF_MAX
+#define SFS_BACKOFF_MAX 32
+#endif
+/* Per-task execution statistics, compiled in with -DSFS_STATS.
+   hist[0] counts runs of 0 probe ticks, hist[i] runs of 2^(i-1) up
+   to 2^i-1 ticks; the last bin also takes everything longer. */
+#ifdef SFS_STATS
+#ifndef SFS_HIST_BINS
+#define SFS_HIST_BINS 16
+#endif
+typedef struct SFS_stat_tg {
+  unsigned long count;
+  unsigned long total;
+  unsigned long max;
+  unsigned long hist[SFS_HIST_BINS];
+} SFS_stat;
+#endif
+/* Dispatch trace, compiled in with -DSFS_TRACE.  Fixed-size binary
+   records go into a caller-owned ring of a power of two entries; when
+   it is full the oldest record is overwritten.  `task` is the index of
+   the TCB in the pool.  A dispatch record spans the task call, the
+   other events have start == end.  Records are written as events end,
+   so a kill or change made by a task comes before its dispatch.
+   tools/sfs_trace2json converts a dump into Chrome/Perfetto trace
+   JSON. */
+#ifdef SFS_TRACE
+#define SFS_EV_DISPATCH 0
+#define SFS_EV_FORK 1
+#define SFS_EV_KILL 2
+#define SFS_EV_CHANGE 3
+typedef struct SFS_event_tg {
+  unsigned long start;
+  unsigned long end;
+  unsigned int task;            /* as wide as the pool size */
+  unsigned short type;
+} SFS_event;
+#endif
+/* Event flag group: a word of flags that tasks wait on with
+   SFS_waitAny()/SFS_waitAll() instead of polling a global every pass.
+   A waiting task is off the queues and costs nothing until
+   SFS_setFlags() (or SFS_postFlags() from an ISR) sets what it waits
+   for.  Set up with SFS_flagsInit(); one group serves one instance. */
+typedef struct SFS_flags_tg {
+  unsigned long bits;           /* flags currently set */
+  unsigned long watched;        /* flags some waiter looks at, maybe more */
+  struct SFS_tg *pWaiter;       /* waiting tasks, through pWaiter */
+} SFS_flags;
+/* Task Control Block.  The members a dispatch pass reads or writes
+   for every task come first (56 bytes with 64-bit pointers), so the
+   walk no longer reaches past the name and the timing fields to find
+   the function pointer; everything else follows. */
 struct SFS_tg {
-  char name[SFS_NAME_SIZE];
-  unsigned short order;
-  struct SFS_tg *pFront;
   struct SFS_tg *pBack;
-  /* ---------- */
   void (*pFunction)(void);
-  char work[SFS_WORK_SIZE];
+  void (*pEntry)(void *);       /* set by SFS_forkArg, called with pArg */
+  void *pArg;
+  struct SFS_tg *pFront;
+  unsigned short state;         /* SFS_PERIODIC | SFS_DOZE | SFS_TIMED | SFS_KILLED | SFS_MOVED | SFS_SUSPENDED | SFS_WAITING | SFS_PENDING | SFS_NAPPING */
+  unsigned short order;
+  unsigned short level;
+  unsigned short gen;
+  unsigned long ran;            /* pass it last ran in */
+  /* ---------- */
+  char name[SFS_NAME_SIZE];
+  struct SFS_tg *pHash;
+  struct SFS_tg **ppHash;       /* the link pointing here, NULL if not indexed */
+  unsigned long wake;           /* tick to wake at */
+  unsigned long period;         /* 0 unless forked periodic */
+  unsigned long deadline;       /* relative, SFS_POLICY_EDF only */
+  unsigned long due;            /* absolute deadline while ready */
+  unsigned int slot;            /* heap position + 1, 0 when not in it */
+  unsigned long group;          /* groups it belongs to, one bit each */
+  void **pMail;                 /* mailbox of message pointers, caller-owned */
+  unsigned int mailMask;        /* mailbox slots - 1 */
+  unsigned int mailHead;        /* messages sent */
+  unsigned int mailTail;        /* messages received */
+  SFS_flags *pFlags;            /* group waited on, NULL if none */
+  struct SFS_tg *pWaiter;       /* next task waiting on the same group */
+  unsigned long waitMask;
+  unsigned short waitAll;       /* all of waitMask, not any */
+  unsigned short backoff;       /* passes between runs while idle, 0 if busy */
+  unsigned short reorder;       /* order given by SFS_change, taken once it returns */
+  char *work;                   /* carved from the instance's arena */
+  unsigned int workSize;
+#ifdef SFS_STATS
+  SFS_stat stat;
+#endif
 };
+/* Stackless coroutines (protothread style).  The resume point lives in
+   an SFS_co member of the task's work area, which SFS_fork() clears,
+   so a task can yield in the middle of a loop and carry on from there
+   on its next run.  Locals do not survive a yield; keep them in the
+   work area too.  Use one macro per line, as the resume point is the
+   line number.
+     SFS_BEGIN(co)           start of the resumable body
+     SFS_YIELD(co)           return now, resume after this line
+     SFS_WAIT_UNTIL(co,c)    return until c is true
+     SFS_END(co)             end of the body; the next run starts over */
+typedef unsigned short SFS_co;
+#define SFS_BEGIN(co) switch(co){ case 0:
+#define SFS_YIELD(co) do{ (co) = __LINE__; return; case __LINE__:; }while(0)
+#define SFS_WAIT_UNTIL(co,c) do{ (co) = __LINE__; case __LINE__: if(!(c)) return; }while(0)
+#define SFS_END(co) } (co) = 0; return
+/* Static task table.  List the tasks once in an X-macro, in ascending
+   order, and let SFS_TABLE() turn it into a const array (ROM on most
+   targets) that SFS_adopt() links without sorting:
+     #define APP_TASKS(X) \
+       X("LED",  0, led_task) \
+       X("COMM", 1, comm_task)
+     SFS_TABLE(app_table, APP_TASKS);
+     SFS_adopt(app_table, SFS_COUNT(app_table));
+   Like SFS_fork(), it returns -1 on success.  It links all of the
+   table or none of it: 0 means the pool or the arena ran out, and the
+   entries linked before that were released again.               */
+typedef struct SFS_entry_tg {
+  char *name;
+  short order;
+  void (*pFunction)(void);
+} SFS_entry;
+#define SFS_ENTRY(name,order,func) { name, order, func },
+#define SFS_TABLE(table,list) static const SFS_entry table[] = { list(SFS_ENTRY) }
+#define SFS_COUNT(table) (sizeof(table)/sizeof((table)[0]))
+/* Command queue for interrupt handlers and other threads, which must
+   not touch an instance directly.  They post fork, kill and wake
+   requests with SFS_postFork()/SFS_postKill()/SFS_postWake() and set
+   event flags with SFS_postFlags(); the dispatcher carries them out
+   at the start of each pass.  The slots
+   are caller-owned, a power of two of them.  Without an injected
+   compare-and-swap there must be a single producer (e.g. one ISR);
+   with one any number of producers may post.  Neither side blocks or
+   takes a lock: a post to a full queue fails.  The optional fence
+   orders the slot contents against its sequence number on targets
+   that reorder stores (multi-core); single-core ISRs need none. */
+#define SFS_CMD_FORK 1
+#define SFS_CMD_KILL 2
+#define SFS_CMD_WAKE 3
+#define SFS_CMD_FLAGS 4
+typedef struct SFS_cmd_tg {
+  volatile unsigned long seq;   /* publication state of the slot */
+  unsigned short op;
+  short order;
+  SFS_handle handle;
+  void (*pFunction)(void);
+  char name[SFS_NAME_SIZE];
+  SFS_flags *pFlags;
+  unsigned long bits;
+} SFS_cmd;
+typedef struct SFS_queue_tg {
+  SFS_cmd *pSlot;
+  unsigned long mask;
+  volatile unsigned long head;  /* next slot to claim, producers */
+  volatile unsigned long tail;  /* next slot to carry out, dispatcher */
+  int (*pCas)(volatile unsigned long *,unsigned long,unsigned long);
+  void (*pFence)(void);
+  unsigned long failed;         /* requests that could not be carried out */
+} SFS_queue;
+/* Scheduler instance.  Everything a scheduler owns lives here, so each
+   instance (e.g. one per worker thread) only touches its own memory.
+   The members are private to sfs.c; the layout is public only so that
+   instances can be allocated statically. */
+typedef struct SFS_ctx_tg {
+  struct SFS_tg *pTask;                     /* ready list head */
+  short policy;                             /* SFS_POLICY_ORDER | SFS_POLICY_EDF */
+  struct SFS_tg **pHeap;                    /* EDF ready heap, caller-owned */
+  unsigned int heapCount;
+  struct SFS_tg *pPool;                     /* free list head */
+  struct SFS_tg *exe;                       /* running task */
+  struct SFS_tg *pNext;                     /* dispatch cursor */
+  struct SFS_tg *pBase;                     /* TCB pool */
+  unsigned int poolSize;
+  unsigned long bmWord;                     /* non-empty words of bmLevel */
+  unsigned long bmLevel[SFS_LEVEL_WORDS];   /* non-empty order levels */
+  struct SFS_tg *pLast[SFS_ORDER_LEVELS];   /* tail of each order level */
+  struct SFS_tg **pName;                    /* name index */
+  unsigned int nameMask;                    /* buckets - 1 */
+  struct SFS_tg *pBucket[SFS_HASH_SIZE];    /* built-in name index */
+  unsigned long (*pTimer)(void);            /* injected tick source */
+  unsigned long now;                        /* tick of this pass */
+  unsigned long tick;                       /* next tick the wheel handles */
+  unsigned int timed;                       /* tasks on the wheel */
+  unsigned long pass;                       /* passes started */
+  unsigned int napping;                     /* tasks backed off */
+  void (*pIdle)(unsigned long);             /* injected idle hook */
+  struct SFS_tg *pReap;                     /* killed this pass, not yet released */
+  struct SFS_tg *pMoved;                    /* moved down this pass, not yet relinked */
+  SFS_queue *pQueue;                        /* requests from ISRs/threads */
+  int open;                                 /* a pass is under way, maybe cut short */
+  long ran;                                 /* tasks run so far in this pass */
+  char *pArena;                             /* work area arena */
+  char *pTop;                               /* bump pointer */
+  char *pEnd;
+  SFS_blk *pFree;                           /* released work areas */
+#ifdef SFS_STATS
+  unsigned long (*pProbe)(void);            /* injected stats clock */
+#endif
+#ifdef SFS_TRACE
+  SFS_event *pRing;                         /* trace records, caller-owned */
+  unsigned long ringMask;
+  unsigned long ringHead;                   /* records written */
+  unsigned long ringTail;                   /* records read */
+  unsigned long (*pStamp)(void);            /* injected trace clock */
+#endif
+  unsigned long bmWheel[SFS_WHEEL_LEVELS];  /* non-empty slots per level */
+  struct SFS_tg *pWheel[SFS_WHEEL_LEVELS][SFS_WHEEL_SLOTS];
+  struct SFS_tg *pNap[SFS_BACKOFF_MAX];     /* backed off, by the pass they rejoin */
+#if SFS_CACHE_LINE > 0
+  char guard[SFS_CACHE_LINE];
+#endif
+} SFS_ctx;
 /*******************************
 [ function organization - PlantUML ]
 
@@ -32,30 +303,153 @@ skinparam packagePadding 10
 
 package "SFS Public API" {
   class SFS_initialize
+  class SFS_initializePool
   class SFS_dispatch
+  class SFS_dispatchFor
   class SFS_fork
+  class SFS_forkSize
+  class SFS_forkArg
+  class SFS_adopt
+  class SFS_arena
+  class SFS_names
   class SFS_kill
+  class SFS_killByName
+  class SFS_killHandle
   class SFS_change
   class SFS_work
   class SFS_otherWork
+  class SFS_lookup
+  class SFS_workOf
+  class SFS_timer
+  class SFS_forkPeriodic
+  class SFS_sleep
+  class SFS_report
+  class SFS_idle
+  class SFS_next
+  class SFS_probe
+  class SFS_stats
+  class SFS_policy
+  class SFS_deadline
+  class SFS_trace
+  class SFS_traceRead
+  class SFS_traceName
+  class SFS_suspend
+  class SFS_resume
+  class SFS_group
+  class SFS_suspendGroup
+  class SFS_resumeGroup
+  class SFS_mailbox
+  class SFS_send
+  class SFS_recv
+  class SFS_flagsInit
+  class SFS_setFlags
+  class SFS_clearFlags
+  class SFS_waitAny
+  class SFS_waitAll
+  class SFS_postFlags
+  class SFS_wake
+  class SFS_listen
+  class SFS_queueInit
+  class SFS_postFork
+  class SFS_postKill
+  class SFS_postWake
+}
+
+package "SFS Context API" {
+  class SFS_ctxInitialize
+  class SFS_ctxDispatch
+  class SFS_ctxDispatchFor
+  class SFS_ctxFork
+  class SFS_ctxForkSize
+  class SFS_ctxForkArg
+  class SFS_ctxAdopt
+  class SFS_ctxArena
+  class SFS_ctxNames
+  class SFS_ctxKill
+  class SFS_ctxChange
+  class SFS_ctxWork
+  class SFS_ctxOtherWork
+  class SFS_ctxLookup
+  class SFS_ctxWorkOf
+  class SFS_ctxTimer
+  class SFS_ctxForkPeriodic
+  class SFS_ctxSleep
+  class SFS_ctxReport
+  class SFS_ctxIdle
+  class SFS_ctxNext
+  class SFS_ctxProbe
+  class SFS_ctxStats
+  class SFS_ctxPolicy
+  class SFS_ctxDeadline
+  class SFS_ctxTrace
+  class SFS_ctxTraceRead
+  class SFS_ctxTraceName
+  class SFS_ctxSuspend
+  class SFS_ctxResume
+  class SFS_ctxGroup
+  class SFS_ctxSuspendGroup
+  class SFS_ctxResumeGroup
+  class SFS_ctxMailbox
+  class SFS_ctxSend
+  class SFS_ctxRecv
+  class SFS_ctxSetFlags
+  class SFS_ctxWaitAny
+  class SFS_ctxWaitAll
+  class SFS_ctxWake
+  class SFS_ctxListen
+  class SFS_ctxSnapshot
+  class SFS_ctxRemove
 }
 
 package "Internal Functions" {
   class SFS_obtain
   class SFS_regist
   class SFS_release
-  class SFS_giveup
+  class SFS_reap
+  class SFS_byHandle
+  class SFS_drop
+  class SFS_move
+  class SFS_registFront
+  class SFS_enqueue
+  class SFS_dequeue
+  class SFS_sift
+  class SFS_defer
+  class SFS_record
+  class SFS_park
+  class SFS_unpark
+  class SFS_detach
+  class SFS_wait
+  class SFS_unwait
+  class SFS_claim
+  class SFS_publish
+  class SFS_drain
+  class SFS_wakeup
+  class SFS_nap
+  class SFS_unnap
+  class SFS_rouse
+  class SFS_discard
   class SFS_find
+  class SFS_index
+  class SFS_unindex
+  class SFS_advance
+  class SFS_settle
+  class SFS_arm
+  class SFS_disarm
+  class SFS_account
+  class SFS_prepare
+  class SFS_carve
+  class SFS_uncarve
   class none
 }
 
 package "Utility Functions" {
   class strncpy
   class strcnt
-  class strcmp
+  class strncmp
 }
 
 ' Vertical layout - main flow
+SFS_initialize --> SFS_initializePool : calls
 SFS_initialize --> SFS_dispatch
 SFS_dispatch --> SFS_fork
 SFS_fork --> SFS_kill
@@ -64,16 +458,107 @@ SFS_kill --> SFS_change
 ' Internal function calls
 SFS_fork --> SFS_obtain : calls
 SFS_fork --> SFS_regist : calls
-SFS_kill --> SFS_giveup : calls
-SFS_giveup --> SFS_release : calls
+SFS_initialize --> SFS_ctxInitialize : default instance
+SFS_dispatch --> SFS_ctxDispatch : default instance
+SFS_dispatchFor --> SFS_ctxDispatchFor : default instance
+SFS_ctxDispatch --> SFS_run : whole pass
+SFS_ctxDispatchFor --> SFS_run : until the budget is spent
+SFS_ctxDispatch --> SFS_drop : killed on return
+SFS_ctxDispatch --> SFS_release : end of pass
+SFS_killByName --> SFS_reap : calls
+SFS_killHandle --> SFS_byHandle : calls
+SFS_killHandle --> SFS_reap : calls
+SFS_reap --> SFS_drop : other task
+SFS_drop --> SFS_discard : outside a pass
+SFS_ctxDispatch --> SFS_move : order changed
+SFS_move --> SFS_regist : moved up
+SFS_ctxDispatch --> SFS_registFront : moved down, end of pass
+SFS_discard --> SFS_release : calls
+SFS_ctxRemove --> SFS_discard : calls
+SFS_policy --> SFS_ctxPolicy : default instance
+SFS_names --> SFS_ctxNames : default instance
+SFS_deadline --> SFS_ctxDeadline : default instance
+SFS_regist --> SFS_enqueue : SFS_POLICY_EDF
+SFS_unlink --> SFS_dequeue : SFS_POLICY_EDF
+SFS_enqueue --> SFS_sift : calls
+SFS_dequeue --> SFS_sift : calls
+SFS_ctxDispatch --> SFS_defer : SFS_POLICY_EDF, after a task ran
+SFS_ctxDispatch --> SFS_advance : wakes due tasks
+SFS_ctxDispatch --> SFS_settle : after a timed task ran
+SFS_settle --> SFS_arm : calls
+SFS_advance --> SFS_arm : cascades
+SFS_advance --> SFS_regist : wakes
+SFS_discard --> SFS_disarm : sleeping task
+SFS_ctxDispatch --> SFS_ctxNext : nothing ready
+SFS_idle --> SFS_ctxIdle : default instance
+SFS_ctxForkSize --> SFS_carve : work area
+SFS_forkArg --> SFS_ctxForkArg : default instance
+SFS_adopt --> SFS_ctxAdopt : default instance
+SFS_ctxAdopt --> SFS_prepare : per entry
+SFS_ctxAdopt --> SFS_regist : out-of-order entry
+SFS_release --> SFS_uncarve : work area
+SFS_ctxDispatch --> SFS_account : SFS_STATS only
+SFS_trace --> SFS_ctxTrace : default instance
+SFS_traceRead --> SFS_ctxTraceRead : default instance
+SFS_ctxDispatch --> SFS_record : SFS_TRACE only
+SFS_suspend --> SFS_ctxSuspend : default instance
+SFS_resume --> SFS_ctxResume : default instance
+SFS_suspendGroup --> SFS_ctxSuspendGroup : default instance
+SFS_resumeGroup --> SFS_ctxResumeGroup : default instance
+SFS_ctxSuspend --> SFS_park : calls
+SFS_ctxSuspendGroup --> SFS_park : each member
+SFS_ctxResume --> SFS_unpark : calls
+SFS_ctxResumeGroup --> SFS_unpark : each member
+SFS_park --> SFS_detach : other task
+SFS_drop --> SFS_detach : calls
+SFS_unpark --> SFS_regist : ready
+SFS_unpark --> SFS_arm : still sleeping
+SFS_mailbox --> SFS_ctxMailbox : default instance
+SFS_send --> SFS_ctxSend : default instance
+SFS_recv --> SFS_ctxRecv : default instance
+SFS_ctxMailbox --> SFS_park : starts waiting
+SFS_ctxSend --> SFS_unpark : mail arrived
+SFS_setFlags --> SFS_ctxSetFlags : default instance
+SFS_waitAny --> SFS_ctxWaitAny : default instance
+SFS_waitAll --> SFS_ctxWaitAll : default instance
+SFS_ctxWaitAny --> SFS_wait : calls
+SFS_ctxWaitAll --> SFS_wait : calls
+SFS_wait --> SFS_park : not set yet
+SFS_ctxSetFlags --> SFS_unpark : condition met
+SFS_drop --> SFS_unwait : killed while waiting
+SFS_drain --> SFS_ctxSetFlags : flags request
+SFS_report --> SFS_ctxReport : default instance
+SFS_ctxReport --> SFS_park : idle
+SFS_ctxDispatch --> SFS_nap : reported idle
+SFS_ctxDispatch --> SFS_rouse : start of a pass
+SFS_rouse --> SFS_unpark : back-off over
+SFS_wakeup --> SFS_unnap : backed off
+SFS_drop --> SFS_unnap : killed while backed off
+SFS_wake --> SFS_ctxWake : default instance
+SFS_listen --> SFS_ctxListen : default instance
+SFS_ctxWake --> SFS_wakeup : calls
+SFS_postFork --> SFS_claim : calls
+SFS_postFork --> SFS_publish : calls
+SFS_ctxDispatch --> SFS_drain : start of a pass
+SFS_drain --> SFS_spawn : fork request
+SFS_drain --> SFS_reap : kill request
+SFS_drain --> SFS_wakeup : wake request
+SFS_prepare --> SFS_record : fork
+SFS_drop --> SFS_record : kill
+SFS_ctxChange --> SFS_record : change
 SFS_otherWork --> SFS_find : calls
+SFS_lookup --> SFS_find : calls
+SFS_fork --> SFS_index : calls
+SFS_change --> SFS_index : calls
+SFS_discard --> SFS_unindex : calls
+SFS_ctxNames --> SFS_index : rehash
 SFS_change --> strncpy : calls
-SFS_find --> strcmp : calls
+SFS_find --> strncmp : calls
 strncpy --> strcnt : calls
 
 ' Additional internal dependencies
 SFS_regist --> strncpy : calls
-SFS_find --> strcmp : calls
+SFS_find --> strncmp : calls
 
 note right of SFS_initialize
   Initialize task management system
@@ -92,7 +577,7 @@ end note
 
 note right of SFS_kill
   Terminate current running task
-  Call giveup function on next execution
+  Leaves the list as soon as it returns, in the same pass
 end note
 @enduml
 
@@ -104,16 +589,374 @@ end note
   while(1)
     SFS_dispatch();
   ------------------------------
+
+- Usage (caller-owned pool) -
+  ------------------------------
+  static struct SFS_tg pool[500];
+  static SFS_ARENA(arena,500,SFS_WORK_SIZE);
+  static struct SFS_tg *names[512];  power of two
+  SFS_initializePool(pool,500);
+  SFS_arena(arena,sizeof(arena));
+  SFS_names(names,512);
+  SFS_forkSize("BIG",0,big_task,sizeof(struct big_work));
+  ------------------------------
+  SFS_initialize() and SFS_initializePool() come with a built-in arena
+  of SFS_TASK_MAX work areas of SFS_WORK_SIZE bytes, so a pool that
+  forks no more tasks than that runs without SFS_arena(); past it
+  SFS_fork() returns 0.  SFS_ctxInitialize() has no arena until
+  SFS_ctxArena().  The name index has SFS_HASH_SIZE
+  buckets unless SFS_names() hands it a table; about one bucket per
+  task keeps the name lookups short.  Taking a task off the index
+  costs the same at any size.
+
+- Usage (one scheduler per thread) -
+  ------------------------------
+  static SFS_ctx ctx;
+  static struct SFS_tg pool[64];
+  static SFS_ARENA(arena,64,SFS_WORK_SIZE);
+  SFS_ctxInitialize(&ctx,pool,64);
+  SFS_ctxArena(&ctx,arena,sizeof(arena));
+  SFS_ctxFork(&ctx,"TASK1",0,task1);
+  while(1)
+    SFS_ctxDispatch(&ctx);
+  ------------------------------
+  Every public function has an SFS_ctx variant taking the instance as
+  its first argument.  The context-free functions act on a default
+  instance set up by SFS_initialize()/SFS_initializePool().
+
+- Usage (timed tasks) -
+  ------------------------------
+  SFS_timer(GetFreeRunCounter);
+  SFS_forkPeriodic("BLINK",0,blink,10);   runs every 10 ticks
+  ...
+  SFS_sleep(100);   inside a task: next run 100 ticks from now
+  ------------------------------
+  Sleeping tasks sit on the timing wheel instead of the ready list,
+  so they cost nothing on a pass.  SFS_dispatch() keeps returning
+  non-zero while any task is ready or sleeping.
+
+- Usage (bounded dispatch) -
+  ------------------------------
+  SFS_timer(GetFreeRunCounter);
+  while(1){
+    if(SFS_dispatchFor(50)==-1)   at most ~50 ticks, then back here
+      ;                           pass cut short, resumes next call
+    poll_io();
+  }
+  ------------------------------
+  A pass cut short keeps its place: the next call starts with the
+  task that was due next, so no task is skipped or run twice.  The
+  budget is checked after each task, and at least one task runs.
+  Without a timer the budget counts tasks.
+
+- Usage (earliest deadline first) -
+  ------------------------------
+  static struct SFS_tg *heap[SFS_TASK_MAX];
+  SFS_initialize();
+  SFS_timer(GetFreeRunCounter);
+  SFS_policy(SFS_POLICY_EDF,heap,SFS_TASK_MAX);
+  SFS_fork("AUDIO",0,audio);
+  SFS_deadline("AUDIO",5);        due 5 ticks after it became ready
+  SFS_forkPeriodic("UI",1,ui,20); deadline = period
+  ------------------------------
+  Every ready task still runs once per pass, earliest absolute
+  deadline first.  A task becomes ready again when it returns, or
+  when it wakes up on the wheel.  The heap needs one entry per TCB.
+
+- Usage (tickless idle) -
+  ------------------------------
+  void idle(unsigned long ticks)   called when nothing is ready
+  {
+    nanosleep()/epoll_wait()/WFI for at most `ticks`
+  }
+  SFS_idle(idle);
+  while(1)
+    SFS_dispatch();
+  ------------------------------
+
+- Usage (coroutine task) -
+  ------------------------------
+  struct my_work { SFS_co co; int i; };
+  void task(void)
+  {
+    struct my_work *w = SFS_work();
+    SFS_BEGIN(w->co);
+    for(w->i=0;w->i<10;w->i++){
+      step(w->i);
+      SFS_YIELD(w->co);
+    }
+    SFS_WAIT_UNTIL(w->co,ready());
+    SFS_kill();
+    SFS_END(w->co);
+  }
+  ------------------------------
+
+- Usage (task with a context argument) -
+  ------------------------------
+  void conn_task(void *arg)
+  {
+    struct conn *c = arg;
+    poll_conn(c);
+  }
+  SFS_forkArg("CONN0",0,conn_task,&conn[0]);
+  SFS_forkArg("CONN1",0,conn_task,&conn[1]);
+  ------------------------------
+  The dispatcher calls conn_task(&conn[n]) directly; no SFS_work()
+  or name lookup is needed to reach the connection.
+
+- Usage (static task table) -
+  ------------------------------
+  #define APP_TASKS(X) \
+    X("SENSOR", 0, sensor_task) \
+    X("CTRL",   1, ctrl_task) \
+    X("LOG",    5, log_task)
+  SFS_TABLE(app_table, APP_TASKS);
+
+  SFS_initialize();
+  SFS_adopt(app_table, SFS_COUNT(app_table));
+  ------------------------------
+  A warm restart repeats the same two calls; the table is already in
+  dispatch order, so every entry is appended without a search.
+
+- Usage (statistics, build with -DSFS_STATS) -
+  ------------------------------
+  struct SFS_tg *t = 0;
+  SFS_probe(read_cycle_counter);
+  ...
+  while((t = SFS_stats(t)) != 0)
+    print t->name, t->stat.count, t->stat.total, t->stat.max ...
+  ------------------------------
+- Usage (suspend and resume) -
+  ------------------------------
+  SFS_group("LOG",0x01);            groups are bits of a mask
+  SFS_group("UPLOAD",0x01);
+  SFS_suspend("DISPLAY");           screen off
+  SFS_suspendGroup(0x01);           link down: LOG and UPLOAD
+  ...
+  SFS_resumeGroup(0x01);
+  SFS_resume("DISPLAY");
+  ------------------------------
+  A suspended task leaves the ready list (or heap) and the wheel but
+  keeps its TCB, name, handle, order and work area, so a pass never
+  visits it.  A sleeping task resumes at its old wake tick if that is
+  still ahead.  A task may suspend itself; it leaves when it returns.
+
+- Usage (mailboxes) -
+  ------------------------------
+  static void *rx_mail[8];          power of two
+  SFS_fork("RX",0,rx_task);
+  SFS_mailbox("RX",rx_mail,8);
+  h = SFS_lookup("RX");
+  ...
+  SFS_send(h,&frame);               from another task: no copy
+  ...
+  void rx_task(void)
+  {
+    struct frame *f;
+    while((f = SFS_recv())!=NULL)
+      handle(f);                    NULL: waits for the next message
+  }
+  ------------------------------
+  A task with a mailbox is only dispatched while it has mail: once
+  SFS_recv() finds the mailbox empty the task leaves the queues, and
+  SFS_send() puts it back.  Messages move by pointer; the sender owns
+  the payload until the receiver is done with it.
+
+- Usage (event flags) -
+  ------------------------------
+  #define RX_DONE 0x01
+  #define STOP    0x02
+  static SFS_flags events;
+  SFS_flagsInit(&events,0);
+  ...
+  void rx_task(void)
+  {
+    unsigned long got = SFS_waitAny(&events,RX_DONE|STOP);
+    if(!got)
+      return;                       waits, off the queues, until set
+    SFS_clearFlags(&events,got);
+    ...
+  }
+  ...
+  SFS_setFlags(&events,RX_DONE);    from a task
+  SFS_postFlags(&queue,&events,RX_DONE);   from an ISR
+  ------------------------------
+  A wait that is already met returns the flags at once; otherwise it
+  returns 0 and the task is next dispatched when the flags are set.
+  Flags stay set until cleared.
+
+- Usage (adaptive polling) -
+  ------------------------------
+  void uart_poll(void)
+  {
+    if(!uart_rx_ready()){
+      SFS_report(SFS_IDLE);         skips 1, 3, 7, ... passes
+      return;
+    }
+    SFS_report(SFS_BUSY);           every pass again
+    ...
+  }
+  ------------------------------
+  A backed-off task is off the queues, so the passes it sits out cost
+  nothing, and SFS_wake() brings it back early.  It still counts in
+  the value SFS_dispatch() returns, as a sleeping task does.  A run
+  without a report leaves the back-off as it is, so the next
+  SFS_IDLE doubles it from there.
+  With a timer, each tick the idle hook sleeps stands for an empty
+  pass: SFS_next() is the passes left to the first backed-off task,
+  one tick each, and the hook sleeps that long.  Without a timer
+  SFS_next() is 0 while a task is backed off, so the hook must not
+  sleep then.
+
+- Usage (requests from interrupts and threads) -
+  ------------------------------
+  static SFS_cmd slot[16];          power of two
+  static SFS_queue queue;
+  SFS_queueInit(&queue,slot,16,cas,fence);   cas/fence NULL: one producer
+  SFS_listen(&queue);
+  h = SFS_lookup("RX");
+  ...
+  void uart_isr(void)
+  {
+    SFS_postWake(&queue,h);         RX was sleeping, runs next pass
+  }
+  ------------------------------
+  Producers only touch the queue; SFS_dispatch() forks, kills and
+  wakes at the start of the next pass.  queue.failed counts requests
+  that could not be carried out (pool full, stale handle).
+
+- Usage (dispatch trace, build with -DSFS_TRACE) -
+  ------------------------------
+  static SFS_event ring[256];       power of two
+  SFS_trace(ring,256,GetFreeRunCounter);
+  ...
+  n = SFS_traceRead(out,256);       oldest first, e.g. from a debug task
+  write out[0..n-1] and SFS_traceName(i) to the host
+  ------------------------------
+  Recording is a clock read and four stores per event; nothing is
+  formatted on the target.  On the host:
+    tools/sfs_trace2json dump.sfst > trace.json   (chrome://tracing, Perfetto)
 *******************************/
 /* Function required before using it */
 extern short SFS_initialize(void);
+extern short SFS_initializePool(struct SFS_tg *,unsigned int);
 extern short SFS_dispatch(void);
+extern short SFS_dispatchFor(unsigned long);
 extern short SFS_fork(char *,short,void (*)());
+extern short SFS_forkSize(char *,short,void (*)(),unsigned int);
+extern short SFS_forkArg(char *,short,void (*)(void *),void *);
+extern short SFS_adopt(const SFS_entry *,unsigned int);
+extern short SFS_arena(void *,unsigned int);
+extern short SFS_names(struct SFS_tg **,unsigned int);
 /* Effective function within a task */
 extern void *SFS_work(void);
 extern void *SFS_otherWork(char *);
 extern short SFS_kill(void);
+/* Names need not be unique: the functions taking a name act on the
+   task of that name forked, or renamed by SFS_change(), last. */
+extern short SFS_killByName(char *);
+extern short SFS_killHandle(SFS_handle);
 extern short SFS_change(char *,short,void (*)());
+/* Handle based access, resolves the name once */
+extern SFS_handle SFS_lookup(char *);
+extern void *SFS_workOf(SFS_handle);
+/* Timed tasks, driven by an injected tick source */
+extern void SFS_timer(unsigned long (*)(void));
+extern short SFS_forkPeriodic(char *,short,void (*)(),unsigned long);
+extern short SFS_sleep(unsigned long);
+extern short SFS_report(short);
+extern void SFS_idle(void (*)(unsigned long));
+extern unsigned long SFS_next(void);
+#ifdef SFS_STATS
+/* Execution statistics */
+extern void SFS_probe(unsigned long (*)(void));
+extern struct SFS_tg *SFS_stats(struct SFS_tg *);
+#endif
+/* Suspend and resume, by task or by group */
+extern short SFS_suspend(char *);
+extern short SFS_resume(char *);
+extern short SFS_group(char *,unsigned long);
+extern unsigned int SFS_suspendGroup(unsigned long);
+extern unsigned int SFS_resumeGroup(unsigned long);
+/* Mailboxes of message pointers */
+extern short SFS_mailbox(char *,void **,unsigned int);
+extern short SFS_send(SFS_handle,void *);
+extern void *SFS_recv(void);
+/* Event flag groups */
+extern void SFS_flagsInit(SFS_flags *,unsigned long);
+extern unsigned int SFS_setFlags(SFS_flags *,unsigned long);
+extern void SFS_clearFlags(SFS_flags *,unsigned long);
+extern unsigned long SFS_waitAny(SFS_flags *,unsigned long);
+extern unsigned long SFS_waitAll(SFS_flags *,unsigned long);
+/* Requests from interrupt handlers and other threads */
+extern short SFS_wake(SFS_handle);
+extern void SFS_listen(SFS_queue *);
+extern short SFS_queueInit(SFS_queue *,SFS_cmd *,unsigned long,int (*)(volatile unsigned long *,unsigned long,unsigned long),void (*)(void));
+extern short SFS_postFork(SFS_queue *,char *,short,void (*)());
+extern short SFS_postKill(SFS_queue *,SFS_handle);
+extern short SFS_postWake(SFS_queue *,SFS_handle);
+extern short SFS_postFlags(SFS_queue *,SFS_flags *,unsigned long);
+/* Scheduling policy */
+extern short SFS_policy(short,struct SFS_tg **,unsigned int);
+extern short SFS_deadline(char *,unsigned long);
+#ifdef SFS_TRACE
+/* Dispatch trace */
+extern short SFS_trace(SFS_event *,unsigned long,unsigned long (*)(void));
+extern unsigned long SFS_traceRead(SFS_event *,unsigned long);
+extern char *SFS_traceName(unsigned int);
+#endif
+
+/* Re-entrant variants on a caller-owned instance */
+extern short SFS_ctxInitialize(SFS_ctx *,struct SFS_tg *,unsigned int);
+extern short SFS_ctxDispatch(SFS_ctx *);
+extern short SFS_ctxDispatchFor(SFS_ctx *,unsigned long);
+extern short SFS_ctxFork(SFS_ctx *,char *,short,void (*)());
+extern short SFS_ctxForkSize(SFS_ctx *,char *,short,void (*)(),unsigned int);
+extern short SFS_ctxForkArg(SFS_ctx *,char *,short,void (*)(void *),void *);
+extern short SFS_ctxAdopt(SFS_ctx *,const SFS_entry *,unsigned int);
+extern short SFS_ctxArena(SFS_ctx *,void *,unsigned int);
+extern short SFS_ctxNames(SFS_ctx *,struct SFS_tg **,unsigned int);
+extern void *SFS_ctxWork(SFS_ctx *);
+extern void *SFS_ctxOtherWork(SFS_ctx *,char *);
+extern short SFS_ctxKill(SFS_ctx *);
+extern short SFS_ctxKillByName(SFS_ctx *,char *);
+extern short SFS_ctxKillHandle(SFS_ctx *,SFS_handle);
+extern short SFS_ctxChange(SFS_ctx *,char *,short,void (*)());
+extern SFS_handle SFS_ctxLookup(SFS_ctx *,char *);
+extern void *SFS_ctxWorkOf(SFS_ctx *,SFS_handle);
+extern void SFS_ctxTimer(SFS_ctx *,unsigned long (*)(void));
+extern short SFS_ctxForkPeriodic(SFS_ctx *,char *,short,void (*)(),unsigned long);
+extern short SFS_ctxSleep(SFS_ctx *,unsigned long);
+extern short SFS_ctxReport(SFS_ctx *,short);
+extern void SFS_ctxIdle(SFS_ctx *,void (*)(unsigned long));
+extern unsigned long SFS_ctxNext(SFS_ctx *);
+#ifdef SFS_STATS
+extern void SFS_ctxProbe(SFS_ctx *,unsigned long (*)(void));
+extern struct SFS_tg *SFS_ctxStats(SFS_ctx *,struct SFS_tg *);
+#endif
+extern short SFS_ctxPolicy(SFS_ctx *,short,struct SFS_tg **,unsigned int);
+extern short SFS_ctxDeadline(SFS_ctx *,char *,unsigned long);
+extern short SFS_ctxSuspend(SFS_ctx *,char *);
+extern short SFS_ctxResume(SFS_ctx *,char *);
+extern short SFS_ctxGroup(SFS_ctx *,char *,unsigned long);
+extern unsigned int SFS_ctxSuspendGroup(SFS_ctx *,unsigned long);
+extern unsigned int SFS_ctxResumeGroup(SFS_ctx *,unsigned long);
+extern short SFS_ctxMailbox(SFS_ctx *,char *,void **,unsigned int);
+extern short SFS_ctxSend(SFS_ctx *,SFS_handle,void *);
+extern void *SFS_ctxRecv(SFS_ctx *);
+extern unsigned int SFS_ctxSetFlags(SFS_ctx *,SFS_flags *,unsigned long);
+extern unsigned long SFS_ctxWaitAny(SFS_ctx *,SFS_flags *,unsigned long);
+extern unsigned long SFS_ctxWaitAll(SFS_ctx *,SFS_flags *,unsigned long);
+extern short SFS_ctxWake(SFS_ctx *,SFS_handle);
+extern void SFS_ctxListen(SFS_ctx *,SFS_queue *);
+#ifdef SFS_TRACE
+extern short SFS_ctxTrace(SFS_ctx *,SFS_event *,unsigned long,unsigned long (*)(void));
+extern unsigned long SFS_ctxTraceRead(SFS_ctx *,SFS_event *,unsigned long);
+extern char *SFS_ctxTraceName(SFS_ctx *,unsigned int);
+#endif
+/* Hooks for dispatchers layered on an instance (e.g. libs/ws) */
+extern unsigned int SFS_ctxSnapshot(SFS_ctx *,struct SFS_tg **,unsigned int);
+extern short SFS_ctxRemove(SFS_ctx *,struct SFS_tg *);
 
 #endif
 /* [EOF] */
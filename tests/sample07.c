@@ -0,0 +1,119 @@
+/*
+  sample07.c - SFS Caller-Owned Task Pool Demo
+
+  This sample demonstrates:
+    - Handing a caller-owned TCB array to SFS_initializePool(), and a
+      count past the 20-bit handle index being refused.
+    - Without an SFS_arena() call the pool still forks SFS_TASK_MAX
+      tasks from the built-in arena, and the next fork fails.
+    - Forking until the pool is exhausted (the next fork fails).
+    - Killing every task and forking the whole pool again, which
+      exercises the O(1) free-list push/pop in SFS_obtain/SFS_release.
+*/
+#include <stdio.h>
+#include "sfs.h"
+
+#define POOL_SIZE 1000
+
+static struct SFS_tg pool[POOL_SIZE];
+static SFS_ARENA(arena, POOL_SIZE, SFS_WORK_SIZE);
+static long g_runs = 0;
+
+void poller_task(void)
+{
+  g_runs++;
+}
+
+void reaper_task(void)
+{
+  g_runs++;
+  SFS_kill();
+}
+
+static int fork_all(void (*func)(void))
+{
+  char name[SFS_NAME_SIZE];
+  int i;
+
+  for (i = 0; i < POOL_SIZE; i++) {
+    sprintf(name, "POLL%d", i);
+    if (!SFS_fork(name, i % 4, func)) {
+      break;
+    }
+  }
+  return i;
+}
+
+int main(void)
+{
+  int forked;
+  int errors = 0;
+  short tcnt;
+
+  printf("--- Caller-Owned Pool Test (%d TCBs) ---\n", POOL_SIZE);
+
+  if (SFS_initializePool(pool, 0) != -1) {
+    printf("ERROR: an empty pool should be rejected.\n");
+    errors++;
+  }
+  if (SFS_initializePool(pool, 1048576U) != -1) {
+    printf("ERROR: a pool past the handle index should be rejected.\n");
+    errors++;
+  }
+
+  /* 0. No arena of its own: the built-in one holds SFS_TASK_MAX areas */
+  SFS_initializePool(pool, POOL_SIZE);
+  forked = fork_all(poller_task);
+  printf("Pool without an arena accepted %d tasks.\n", forked);
+  if (forked != SFS_TASK_MAX) {
+    printf("ERROR: expected the built-in arena's %d tasks.\n", SFS_TASK_MAX);
+    errors++;
+  }
+
+  SFS_initializePool(pool, POOL_SIZE);
+  SFS_arena(arena, sizeof(arena));
+
+  /* 1. Fill the pool */
+  forked = fork_all(reaper_task);
+  printf("Forked %d tasks.\n", forked);
+  if (forked != POOL_SIZE) {
+    printf("ERROR: expected %d forks.\n", POOL_SIZE);
+    errors++;
+  }
+  if (SFS_fork("OVERFLOW", 0, poller_task)) {
+    printf("ERROR: fork should fail when the pool is exhausted.\n");
+    errors++;
+  } else {
+    printf("SUCCESS: fork failed as expected when the pool is exhausted.\n");
+  }
+
+  /* 2. Every task kills itself on its first run */
+  tcnt = SFS_dispatch();
+  printf("First pass executed %d tasks.\n", tcnt);
+  SFS_dispatch();
+  if (SFS_dispatch() != 0) {
+    printf("ERROR: all tasks should have been released.\n");
+    errors++;
+  }
+
+  /* 3. The whole pool is available again */
+  forked = fork_all(poller_task);
+  printf("Re-forked %d tasks.\n", forked);
+  if (forked != POOL_SIZE || SFS_dispatch() != POOL_SIZE) {
+    printf("ERROR: released TCBs were not returned to the pool.\n");
+    errors++;
+  }
+
+  /* 4. The built-in pool still holds SFS_TASK_MAX entries */
+  SFS_initialize();
+  forked = fork_all(poller_task);
+  printf("Built-in pool accepted %d tasks (SFS_TASK_MAX=%d).\n", forked, SFS_TASK_MAX);
+  if (forked != SFS_TASK_MAX) {
+    errors++;
+  }
+
+  printf("Total task runs: %ld\n", g_runs);
+  printf("--- sample07.c test %s. ---\n", errors ? "FAILED" : "finished successfully");
+
+  return errors ? 1 : 0;
+}
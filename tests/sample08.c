@@ -0,0 +1,113 @@
+/*
+  sample08.c - SFS Priority Bucket Ordering Demo
+
+  This sample demonstrates:
+    - Forking a few thousand tasks with scattered `order` values.
+    - SFS_dispatch still running them in ascending `order`, with tasks
+      of equal order kept in fork order.
+    - Orders above SFS_ORDER_LEVELS-2, which share the last bucket, are
+      still dispatched in sorted order.
+    - Killing tasks and forking new ones keeps the ordering intact.
+*/
+#include <stdio.h>
+#include "sfs.h"
+
+#define POOL_SIZE 4000
+
+struct workspace {
+  unsigned short order;
+  unsigned long seq;
+};
+
+static struct SFS_tg pool[POOL_SIZE];
+static SFS_ARENA(arena, POOL_SIZE, SFS_WORK_SIZE);
+static unsigned long g_seq = 0;
+static unsigned short g_last_order;
+static unsigned long g_last_seq;
+static int g_first = 1;
+static int g_errors = 0;
+static int g_kill_odd = 0;
+
+void check_task(void)
+{
+  struct workspace *ws = SFS_work();
+
+  if (!g_first) {
+    if (ws->order < g_last_order ||
+        (ws->order == g_last_order && ws->seq < g_last_seq)) {
+      g_errors++;
+    }
+  }
+  g_first = 0;
+  g_last_order = ws->order;
+  g_last_seq = ws->seq;
+
+  if (g_kill_odd && (ws->seq & 1)) {
+    SFS_kill();
+  }
+}
+
+/* Pseudo random orders spread over and beyond the bucket range. */
+static unsigned short next_order(void)
+{
+  static unsigned long lcg = 12345;
+
+  lcg = lcg * 1103515245UL + 12345UL;
+  return (unsigned short)((lcg >> 16) % (SFS_ORDER_LEVELS + 200));
+}
+
+static int fork_some(int count)
+{
+  struct workspace *ws;
+  char name[SFS_NAME_SIZE];
+  unsigned short order;
+  int i;
+
+  for (i = 0; i < count; i++) {
+    order = next_order();
+    sprintf(name, "T%lu", g_seq);
+    if (!SFS_fork(name, order, check_task)) {
+      break;
+    }
+    ws = SFS_otherWork(name);
+    ws->order = order;
+    ws->seq = g_seq++;
+  }
+  return i;
+}
+
+static short run_pass(void)
+{
+  g_first = 1;
+  return SFS_dispatch();
+}
+
+int main(void)
+{
+  short tcnt;
+
+  printf("--- Priority Bucket Ordering Test (%d levels) ---\n", SFS_ORDER_LEVELS);
+
+  SFS_initializePool(pool, POOL_SIZE);
+  SFS_arena(arena, sizeof(arena));
+
+  printf("Forked %d tasks.\n", fork_some(POOL_SIZE / 2));
+  tcnt = run_pass();
+  printf("Pass 1 executed %d tasks, ordering errors: %d\n", tcnt, g_errors);
+
+  /* Kill every odd task, then let the deferred release happen */
+  g_kill_odd = 1;
+  run_pass();
+  g_kill_odd = 0;
+  run_pass();
+  tcnt = run_pass();
+  printf("After killing odd tasks: %d tasks remain, ordering errors: %d\n", tcnt, g_errors);
+
+  printf("Forked %d more tasks.\n", fork_some(POOL_SIZE));
+  tcnt = run_pass();
+  printf("Pass 4 executed %d tasks, ordering errors: %d\n", tcnt, g_errors);
+
+  printf("--- sample08.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
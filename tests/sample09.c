@@ -0,0 +1,127 @@
+/*
+  sample09.c - SFS Handle Based Inter-Task Access Demo
+
+  This sample demonstrates:
+    - The sample03 master/slave pattern, with the master resolving the
+      slave by name once through SFS_lookup() and then reaching its
+      workspace every tick through SFS_workOf() without string compares.
+    - A handle becoming invalid once its task is killed, even after the
+      TCB is reused by a new task with the same name.
+    - SFS_otherWork() resolving names through the hashed index.
+    - SFS_names() moving the index to a caller-owned table of another
+      size, two tasks of one name still resolving to the later one,
+      and killing it uncovering the earlier one.
+*/
+#include <stdio.h>
+#include "sfs.h"
+
+struct slave_ws {
+  unsigned int count;
+};
+
+struct master_ws {
+  SFS_handle slave;
+};
+
+static int g_errors = 0;
+
+void slave_task(void)
+{
+  struct slave_ws *ws = SFS_work();
+
+  if (ws->count) {
+    printf("slave count:%u\n", ws->count);
+  } else {
+    printf("slave end\n");
+    SFS_kill();
+  }
+}
+
+void master_task(void)
+{
+  struct master_ws *ws = SFS_work();
+  struct slave_ws *sws;
+
+  if (ws->slave == SFS_NOHANDLE) {
+    ws->slave = SFS_lookup("SLAVE");
+    printf("master resolved SLAVE once.\n");
+  }
+
+  sws = SFS_workOf(ws->slave);
+  if (sws == NULL) {
+    printf("master: slave handle is no longer valid, master end\n");
+    SFS_kill();
+  } else if (sws->count) {
+    sws->count--;
+  }
+}
+
+void regist_slave(void)
+{
+  struct slave_ws *ws = SFS_work();
+
+  ws->count = 3;
+  SFS_change("SLAVE", 0, slave_task);
+}
+
+int main(void)
+{
+  static struct SFS_tg *names[64];
+  SFS_handle stale, first, second;
+
+  SFS_initialize();
+
+  SFS_fork("Regist SLAVE", 0, regist_slave);
+  SFS_fork("MASTER", 1, master_task);
+  ((struct master_ws *)SFS_otherWork("MASTER"))->slave = SFS_NOHANDLE;
+
+  while (SFS_dispatch());
+
+  /* A killed task's handle must not resolve to its successor */
+  SFS_fork("SLAVE", 0, slave_task);
+  stale = SFS_lookup("SLAVE");
+  ((struct slave_ws *)SFS_workOf(stale))->count = 0;
+  while (SFS_dispatch());
+  if (SFS_workOf(stale) != NULL) {
+    printf("ERROR: handle of a killed task is still valid.\n");
+    g_errors++;
+  }
+  SFS_fork("SLAVE", 0, slave_task);
+  if (SFS_workOf(stale) != NULL || SFS_workOf(SFS_lookup("SLAVE")) == NULL) {
+    printf("ERROR: reused TCB must get a new handle.\n");
+    g_errors++;
+  }
+  if (SFS_lookup("NOBODY") != SFS_NOHANDLE || SFS_otherWork("NOBODY") != NULL) {
+    printf("ERROR: unknown names must not resolve.\n");
+    g_errors++;
+  }
+
+  /* Tasks sharing a name, then the index moved to a larger table */
+  SFS_fork("TWIN", 2, slave_task);
+  first = SFS_lookup("TWIN");
+  SFS_fork("TWIN", 3, slave_task);
+  second = SFS_lookup("TWIN");
+  if (SFS_names(names, 48) != -1) {
+    printf("ERROR: a table that is not a power of two was taken.\n");
+    g_errors++;
+  }
+  if (SFS_names(names, 64) != 0 || second == first ||
+      SFS_lookup("TWIN") != second || SFS_workOf(SFS_lookup("SLAVE")) == NULL) {
+    printf("ERROR: names were lost moving the index.\n");
+    g_errors++;
+  }
+  SFS_killByName("TWIN");
+  if (SFS_lookup("TWIN") != first || SFS_workOf(second) != NULL) {
+    printf("ERROR: killing the later TWIN did not uncover the earlier one.\n");
+    g_errors++;
+  }
+  SFS_killByName("TWIN");
+  if (SFS_lookup("TWIN") != SFS_NOHANDLE) {
+    printf("ERROR: a killed TWIN still resolves.\n");
+    g_errors++;
+  }
+
+  printf("--- sample09.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
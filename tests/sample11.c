@@ -0,0 +1,168 @@
+/*
+  sample11.c - SFS Work-Stealing Scaling Benchmark
+
+  This sample demonstrates:
+    - Running the same task set through libs/ws with 1 to N workers
+      (N = online CPUs, at least 2) and reporting passes per second.
+    - Deliberately unbalanced load: every task forked onto worker 0 is
+      four times heavier, so the other workers have to steal from it.
+    - Per-worker utilization (busy/wall) and steal counts.
+    - Every task still running exactly once per pass, `order` being
+      honoured inside a worker, and SFS_wsKill() releasing a task.
+    - SFS_wsForkArg() tasks being called with their own argument.
+*/
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include "sfs_ws.h"
+
+#define MAX_WORKERS 8
+#define TASKS 64
+#define PASSES 200
+#define SPIN 2000
+#define ARGS 4
+
+struct workspace {
+  unsigned short order;
+  unsigned long runs;
+  unsigned long spin;
+};
+
+SFS_WS_STORAGE(farm, MAX_WORKERS, TASKS + ARGS + 1);
+static SFS_ws ws;
+static struct workspace *g_tasks[TASKS];
+static unsigned long g_argRuns[ARGS];
+static int g_single = 0;
+static unsigned short g_last_order;
+static int g_errors = 0;
+
+void spin_task(void)
+{
+  struct workspace *w = SFS_wsWork();
+  volatile unsigned long sink = 0;
+  unsigned long i;
+
+  for (i = 0; i < w->spin; i++) {
+    sink += i;
+  }
+  /* With a single worker the whole pass follows `order` */
+  if (g_single) {
+    if (w->order < g_last_order) {
+      g_errors++;
+    }
+    g_last_order = w->order;
+  }
+  w->runs++;
+}
+
+void oneshot_task(void)
+{
+  struct workspace *w = SFS_wsWork();
+
+  w->runs++;
+  SFS_wsKill();
+}
+
+void arg_task(void *arg)
+{
+  (*(unsigned long *)arg)++;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static double run(unsigned int workers)
+{
+  SFS_wsStat st;
+  struct workspace *shot;
+  char name[SFS_NAME_SIZE];
+  double start, elapsed;
+  long tcnt;
+  unsigned int i;
+  int p;
+
+  SFS_wsInitialize(&ws, farm_worker, workers, farm_pool, farm_slot, farm_arena, TASKS + ARGS + 1);
+  g_single = (workers == 1);
+
+  for (i = 0; i < TASKS; i++) {
+    sprintf(name, "SPIN%u", i);
+    SFS_wsFork(&ws, name, (unsigned short)(TASKS - i), spin_task);
+    /* Round-robin placement: task i lives on worker i % workers */
+    g_tasks[i] = SFS_ctxOtherWork(&farm_worker[i % workers].ctx, name);
+    g_tasks[i]->order = (unsigned short)(TASKS - i);
+    g_tasks[i]->runs = 0;
+    g_tasks[i]->spin = (i % workers == 0) ? 4 * SPIN : SPIN;
+  }
+  for (i = 0; i < ARGS; i++) {
+    sprintf(name, "ARG%u", i);
+    g_argRuns[i] = 0;
+    SFS_wsForkArg(&ws, name, (unsigned short)i, arg_task, &g_argRuns[i]);
+  }
+  SFS_wsFork(&ws, "ONESHOT", 0, oneshot_task);
+  shot = SFS_ctxOtherWork(&farm_worker[(TASKS + ARGS) % workers].ctx, "ONESHOT");
+  shot->runs = 0;
+
+  start = now();
+  for (p = 0; p < PASSES; p++) {
+    g_last_order = 0;
+    tcnt = SFS_wsDispatch(&ws);
+    if (tcnt != (p == 0 ? TASKS + ARGS + 1 : TASKS + ARGS)) {
+      printf("ERROR: pass %d executed %ld tasks.\n", p, tcnt);
+      g_errors++;
+    }
+  }
+  elapsed = now() - start;
+
+  for (i = 0; i < TASKS; i++) {
+    if (g_tasks[i]->runs != PASSES) {
+      printf("ERROR: task %u ran %lu times.\n", i, g_tasks[i]->runs);
+      g_errors++;
+    }
+  }
+  for (i = 0; i < ARGS; i++) {
+    if (g_argRuns[i] != PASSES) {
+      printf("ERROR: argument task %u ran %lu times.\n", i, g_argRuns[i]);
+      g_errors++;
+    }
+  }
+  if (shot->runs != 1) {
+    printf("ERROR: killed task ran %lu times.\n", shot->runs);
+    g_errors++;
+  }
+
+  printf("%u worker(s): %8.0f passes/s |", workers, PASSES / elapsed);
+  for (i = 0; i < workers; i++) {
+    SFS_wsStats(&ws, i, &st);
+    printf(" w%u %3.0f%% (%lu stolen)", i, st.wall > 0.0 ? 100.0 * st.busy / st.wall : 0.0, st.steals);
+  }
+  printf("\n");
+
+  SFS_wsShutdown(&ws);
+  return PASSES / elapsed;
+}
+
+int main(void)
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  unsigned int n, workers;
+  double base, rate;
+
+  n = (cpus < 2) ? 2 : (cpus > MAX_WORKERS ? MAX_WORKERS : (unsigned int)cpus);
+  printf("--- Work-Stealing Scaling Benchmark (%ld CPUs online, %d tasks) ---\n", cpus, TASKS);
+
+  base = run(1);
+  for (workers = 2; workers <= n; workers++) {
+    rate = run(workers);
+    printf("  speedup x%.2f\n", rate / base);
+  }
+
+  printf("--- sample11.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
@@ -0,0 +1,154 @@
+/*
+  sample12.c - SFS Periodic and Delayed Tasks Demo
+
+  This sample demonstrates:
+    - SFS_timer() taking GetFreeRunCounter() from libs/frcc as the tick
+      source; main() plays the timer interrupt and bumps gFreeRunCounter.
+    - SFS_forkPeriodic(): a task released every 10 ticks without polling
+      the counter itself (compare sample_frcc01).
+    - SFS_sleep(): a task that waits 300 ticks between runs, and one that
+      sleeps longer than the timing wheel spans.
+    - A thousand sleeping tasks costing nothing on passes where they are
+      not due.
+*/
+#include <stdio.h>
+#include "sfs.h"
+#include "frcc.h"
+
+#define POOL_SIZE 1100
+#define SLEEPERS 1000
+#define LONG_SLEEP ((1UL << (5 * SFS_WHEEL_LEVELS)) + 5000UL)
+
+struct timed_ws {
+  unsigned long runs;
+  unsigned long last;
+};
+
+static struct SFS_tg pool[POOL_SIZE];
+static SFS_ARENA(arena, POOL_SIZE, SFS_WORK_SIZE);
+static unsigned long g_calls = 0;
+static int g_errors = 0;
+static int g_stepping = 0;
+
+static void di(void) {}
+static void ei(void) {}
+
+void blink_task(void)
+{
+  struct timed_ws *ws = SFS_work();
+
+  if (!g_stepping && ws->runs && gFreeRunCounter - ws->last != 10) {
+    printf("ERROR: BLINK ran %lu ticks after its previous run.\n", gFreeRunCounter - ws->last);
+    g_errors++;
+  }
+  ws->last = gFreeRunCounter;
+  ws->runs++;
+  g_calls++;
+}
+
+void delay_task(void)
+{
+  struct timed_ws *ws = SFS_work();
+
+  if (ws->runs && gFreeRunCounter - ws->last != 300) {
+    printf("ERROR: DELAY woke %lu ticks after going to sleep.\n", gFreeRunCounter - ws->last);
+    g_errors++;
+  }
+  ws->last = gFreeRunCounter;
+  ws->runs++;
+  g_calls++;
+  if (ws->runs == 5) {
+    SFS_kill();
+  } else {
+    SFS_sleep(300);
+  }
+}
+
+void sleeper_task(void)
+{
+  struct timed_ws *ws = SFS_work();
+
+  ws->runs++;
+  g_calls++;
+  SFS_sleep(5000);
+}
+
+void long_task(void)
+{
+  struct timed_ws *ws = SFS_work();
+
+  g_calls++;
+  if (ws->runs++ == 0) {
+    ws->last = gFreeRunCounter;
+    SFS_sleep(LONG_SLEEP);
+  } else {
+    /* the counter moves in steps of up to 976 ticks here */
+    printf("LONG woke after %lu ticks (asked for %lu).\n", gFreeRunCounter - ws->last, LONG_SLEEP);
+    if (gFreeRunCounter - ws->last < LONG_SLEEP || gFreeRunCounter - ws->last > LONG_SLEEP + 976) {
+      g_errors++;
+    }
+    SFS_kill();
+  }
+}
+
+int main(void)
+{
+  struct timed_ws *blink, *delay;
+  char name[SFS_NAME_SIZE];
+  unsigned long passes = 0;
+  int i;
+
+  printf("--- Periodic and Delayed Tasks Test ---\n");
+
+  FRCInterrupt(di, ei);
+  gFreeRunCounter = 0;
+  SFS_initializePool(pool, POOL_SIZE);
+  SFS_arena(arena, sizeof(arena));
+  SFS_timer(GetFreeRunCounter);
+
+  SFS_forkPeriodic("BLINK", 0, blink_task, 10);
+  SFS_fork("DELAY", 1, delay_task);
+  SFS_fork("LONG", 2, long_task);
+  blink = SFS_otherWork("BLINK");
+  delay = SFS_otherWork("DELAY");
+  blink->runs = delay->runs = 0;
+  ((struct timed_ws *)SFS_otherWork("LONG"))->runs = 0;
+  for (i = 0; i < SLEEPERS; i++) {
+    sprintf(name, "SLEEP%d", i);
+    SFS_fork(name, 3, sleeper_task);
+    ((struct timed_ws *)SFS_otherWork(name))->runs = 0;
+  }
+
+  /* 1. One pass per tick for 2000 ticks */
+  for (gFreeRunCounter = 0; gFreeRunCounter < 2000; gFreeRunCounter++) {
+    SFS_dispatch();
+    passes++;
+  }
+  printf("%lu passes, %lu task calls.\n", passes, g_calls);
+  printf("BLINK ran %lu times, DELAY ran %lu times.\n", blink->runs, delay->runs);
+  if (blink->runs != 200 || delay->runs != 5) {
+    g_errors++;
+  }
+  /* every sleeper ran once; the rest were BLINK, DELAY and LONG */
+  if (g_calls != SLEEPERS + blink->runs + delay->runs + 1) {
+    printf("ERROR: sleeping tasks were called.\n");
+    g_errors++;
+  }
+
+  /* 2. The counter jumps ahead in large steps past the wheel span */
+  g_stepping = 1;
+  while (gFreeRunCounter < 2 * LONG_SLEEP && SFS_otherWork("LONG") != NULL) {
+    gFreeRunCounter += 1;
+    SFS_dispatch();
+    gFreeRunCounter += 976;
+    SFS_dispatch();
+  }
+  if (SFS_otherWork("LONG") != NULL) {
+    printf("ERROR: LONG never woke up.\n");
+    g_errors++;
+  }
+
+  printf("--- sample12.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
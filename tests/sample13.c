@@ -0,0 +1,115 @@
+/*
+  sample13.c - SFS Tickless Idle Demo
+
+  This sample demonstrates:
+    - SFS_idle() registering a hook that SFS_dispatch() calls, instead of
+      an empty pass, whenever no task is ready.
+    - The hook receiving the ticks left until the next timed task and
+      "sleeping" that long; here it simply moves a simulated clock.
+    - The main loop `while(SFS_dispatch());` running about one pass per
+      timed event instead of one per tick, without waking tasks late.
+    - SFS_next() reporting SFS_FOREVER once nothing is waiting.
+*/
+#include <stdio.h>
+#include "sfs.h"
+
+#define END_TICK 10000UL
+
+struct timed_ws {
+  unsigned long runs;
+  unsigned long last;
+};
+
+static unsigned long g_clock = 0;
+static unsigned long g_idle_calls = 0;
+static unsigned long g_slept = 0;
+static int g_errors = 0;
+
+unsigned long clock_ticks(void)
+{
+  return g_clock;
+}
+
+/* Stands in for nanosleep()/epoll_wait()/WFI */
+void idle_hook(unsigned long ticks)
+{
+  g_idle_calls++;
+  if (ticks == SFS_FOREVER) {
+    return;
+  }
+  g_clock += ticks;
+  g_slept += ticks;
+}
+
+void periodic_task(void)
+{
+  struct timed_ws *ws = SFS_work();
+
+  if (ws->runs && g_clock - ws->last != 100) {
+    printf("ERROR: PERIODIC ran %lu ticks after its previous run.\n", g_clock - ws->last);
+    g_errors++;
+  }
+  ws->last = g_clock;
+  if (++ws->runs == END_TICK / 100) {
+    SFS_kill();
+  }
+}
+
+void delayed_task(void)
+{
+  struct timed_ws *ws = SFS_work();
+
+  if (ws->runs && g_clock - ws->last != 2500) {
+    printf("ERROR: DELAYED woke %lu ticks late.\n", g_clock - ws->last - 2500);
+    g_errors++;
+  }
+  ws->last = g_clock;
+  if (++ws->runs == 4) {
+    SFS_kill();
+  } else {
+    SFS_sleep(2500);
+  }
+}
+
+int main(void)
+{
+  struct timed_ws *periodic, *delayed;
+  unsigned long passes = 0;
+
+  printf("--- Tickless Idle Test ---\n");
+
+  SFS_initialize();
+  SFS_timer(clock_ticks);
+  SFS_idle(idle_hook);
+
+  SFS_forkPeriodic("PERIODIC", 0, periodic_task, 100);
+  SFS_fork("DELAYED", 1, delayed_task);
+  periodic = SFS_otherWork("PERIODIC");
+  delayed = SFS_otherWork("DELAYED");
+  periodic->runs = delayed->runs = 0;
+
+  while (SFS_dispatch()) {
+    passes++;
+  }
+
+  printf("%lu ticks: %lu passes, %lu idle calls, %lu ticks spent idle.\n",
+         g_clock, passes, g_idle_calls, g_slept);
+  printf("PERIODIC ran %lu times, DELAYED ran %lu times.\n", periodic->runs, delayed->runs);
+  if (periodic->runs != END_TICK / 100 || delayed->runs != 4) {
+    g_errors++;
+  }
+  /* Every task wake-up costs a pass and an idle call at most, plus a
+     few early reports while a task is still on an upper wheel level */
+  if (passes > 2 * (periodic->runs + delayed->runs) + 20) {
+    printf("ERROR: the loop kept spinning while nothing was ready.\n");
+    g_errors++;
+  }
+  if (SFS_next() != SFS_FOREVER) {
+    printf("ERROR: nothing is waiting, SFS_next() should be SFS_FOREVER.\n");
+    g_errors++;
+  }
+
+  printf("--- sample13.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+/*
+  sample15.c - SFS Stackless Coroutine Demo
+
+  This sample demonstrates:
+    - SFS_BEGIN / SFS_YIELD / SFS_WAIT_UNTIL / SFS_END keeping the
+      resume point in the task's work area, with no state variable or
+      switch written by hand (compare sample01/sample03).
+    - A producer yielding inside a loop and a consumer waiting on a
+      shared mailbox slot.
+    - SFS_fork() clearing the work area, so the coroutines start at
+      SFS_BEGIN without any initialisation by the caller.
+    - SFS_END starting the body over on the next run.
+*/
+#include <stdio.h>
+#include "sfs.h"
+
+#define ITEMS 5
+
+struct producer_ws {
+  SFS_co co;
+  int i;
+};
+
+struct consumer_ws {
+  SFS_co co;
+  int sum;
+  int received;
+};
+
+struct round_ws {
+  SFS_co co;
+  int rounds;
+};
+
+static int g_slot = 0;
+static int g_full = 0;
+static int g_errors = 0;
+
+void producer_task(void)
+{
+  struct producer_ws *ws = SFS_work();
+
+  SFS_BEGIN(ws->co);
+  for (ws->i = 1; ws->i <= ITEMS; ws->i++) {
+    SFS_WAIT_UNTIL(ws->co, !g_full);
+    g_slot = ws->i * 10;
+    g_full = 1;
+    printf("producer: put %d\n", g_slot);
+    SFS_YIELD(ws->co);
+  }
+  printf("producer: done\n");
+  SFS_kill();
+  SFS_END(ws->co);
+}
+
+void consumer_task(void)
+{
+  struct consumer_ws *ws = SFS_work();
+
+  SFS_BEGIN(ws->co);
+  while (ws->received < ITEMS) {
+    SFS_WAIT_UNTIL(ws->co, g_full);
+    ws->sum += g_slot;
+    ws->received++;
+    g_full = 0;
+    printf("consumer: got %d (sum %d)\n", g_slot, ws->sum);
+  }
+  if (ws->sum != 150) {
+    g_errors++;
+  }
+  SFS_kill();
+  SFS_END(ws->co);
+}
+
+/* Three steps per round, then SFS_END restarts the body */
+void round_task(void)
+{
+  struct round_ws *ws = SFS_work();
+
+  SFS_BEGIN(ws->co);
+  printf("round %d: step 1\n", ws->rounds);
+  SFS_YIELD(ws->co);
+  printf("round %d: step 2\n", ws->rounds);
+  SFS_YIELD(ws->co);
+  printf("round %d: step 3\n", ws->rounds);
+  if (++ws->rounds == 2) {
+    SFS_kill();
+  }
+  SFS_END(ws->co);
+}
+
+int main(void)
+{
+  int passes = 0;
+
+  printf("--- Stackless Coroutine Test ---\n");
+
+  SFS_initialize();
+  SFS_fork("PRODUCER", 0, producer_task);
+  SFS_fork("CONSUMER", 1, consumer_task);
+  SFS_fork("ROUND", 2, round_task);
+
+  while (SFS_dispatch()) {
+    passes++;
+  }
+  printf("%d passes.\n", passes);
+
+  printf("--- sample15.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
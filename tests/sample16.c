@@ -0,0 +1,150 @@
+/*
+  sample16.c - SFS Variable-Size Work Area Demo
+
+  This sample demonstrates:
+    - SFS_forkSize() giving each task a work area of the size it needs,
+      carved from a caller-owned arena registered with SFS_arena().
+    - A task whose state is larger than SFS_WORK_SIZE, and tasks that
+      need only a few bytes.
+    - A fork failing on an instance that has no arena yet, and once the
+      arena is exhausted while TCBs are still free, the pool staying
+      usable afterwards.
+    - A released work area being handed to the next task of the same
+      size instead of growing the arena.
+*/
+#include <stdio.h>
+#include "sfs.h"
+
+#define POOL_SIZE 8
+#define HISTORY 25
+#define SMALL_SIZE 4
+
+/* Larger than SFS_WORK_SIZE */
+struct big_ws {
+  unsigned long history[HISTORY];
+  unsigned int n;
+};
+
+static struct SFS_tg pool[POOL_SIZE];
+/* Room for one big task and four small ones */
+static SFS_align arena[(SFS_AREA(sizeof(struct big_ws)) + 4 * SFS_AREA(SMALL_SIZE)) / sizeof(SFS_align)];
+static SFS_ctx g_bare;
+static struct SFS_tg g_bareTcb[1];
+static int g_release = 0;
+static int g_errors = 0;
+
+/* Two rounds over its history, then checks the second round is intact */
+void big_task(void)
+{
+  struct big_ws *ws = SFS_work();
+  unsigned int i;
+
+  ws->history[ws->n % HISTORY] = ws->n;
+  if (++ws->n == 2 * HISTORY) {
+    for (i = 0; i < HISTORY; i++) {
+      if (ws->history[i] != HISTORY + i) {
+        g_errors++;
+      }
+    }
+    printf("BIG kept its %u byte history intact.\n", (unsigned int)sizeof(ws->history));
+    SFS_kill();
+  }
+}
+
+void small_task(void)
+{
+  unsigned char *count = SFS_work();
+
+  ++*count;
+  if (g_release) {
+    SFS_kill();
+  }
+}
+
+int main(void)
+{
+  unsigned char *first, *area[4];
+  char name[SFS_NAME_SIZE];
+  int i, j, forked, passes;
+
+  printf("--- Variable-Size Work Area Test ---\n");
+
+  SFS_ctxInitialize(&g_bare, g_bareTcb, 1);
+  if (SFS_ctxFork(&g_bare, "NONE", 0, small_task) != 0) {
+    printf("ERROR: fork should fail before an arena is registered.\n");
+    g_errors++;
+  }
+  SFS_initializePool(pool, POOL_SIZE);
+  SFS_arena(arena, sizeof(arena));
+
+  /* 1. One big task and as many small ones as the arena holds */
+  if (SFS_forkSize("BIG", 0, big_task, sizeof(struct big_ws)) != -1) {
+    g_errors++;
+  }
+  for (forked = 0, i = 0; i < POOL_SIZE; i++) {
+    sprintf(name, "SMALL%d", i);
+    if (SFS_forkSize(name, 1, small_task, SMALL_SIZE) == -1) {
+      forked++;
+    }
+  }
+  printf("Forked BIG and %d small tasks into a %u byte arena.\n", forked, (unsigned int)sizeof(arena));
+  if (forked != 4) {
+    printf("ERROR: expected the arena to hold 4 small tasks.\n");
+    g_errors++;
+  }
+
+  for (passes = 0; SFS_otherWork("BIG") != NULL; passes++) {
+    SFS_dispatch();
+  }
+  first = SFS_otherWork("SMALL0");
+  if (*first != passes) {
+    printf("ERROR: SMALL0 ran %u times.\n", *first);
+    g_errors++;
+  }
+
+  /* 2. BIG's area is reused by the next task of the same size */
+  if (SFS_forkSize("BIG2", 0, big_task, sizeof(struct big_ws)) != -1) {
+    printf("ERROR: BIG2 did not get the released area.\n");
+    g_errors++;
+  }
+  if (SFS_forkSize("SMALL9", 1, small_task, SMALL_SIZE) != 0) {
+    printf("ERROR: the arena should still be full.\n");
+    g_errors++;
+  }
+  SFS_dispatch();
+  if (((struct big_ws *)SFS_otherWork("BIG2"))->n != 1) {
+    printf("ERROR: BIG2's work area was not cleared.\n");
+    g_errors++;
+  }
+
+  /* 3. The small tasks end and are forked again in the same areas */
+  for (i = 0; i < 4; i++) {
+    sprintf(name, "SMALL%d", i);
+    area[i] = SFS_otherWork(name);
+  }
+  g_release = 1;
+  SFS_dispatch();
+  g_release = 0;
+  SFS_dispatch();
+  for (forked = 0, i = 0; i < POOL_SIZE; i++) {
+    sprintf(name, "AGAIN%d", i);
+    if (SFS_forkSize(name, 1, small_task, SMALL_SIZE) == -1) {
+      forked++;
+      first = SFS_otherWork(name);
+      for (j = 0; j < 4 && area[j] != first; j++) {
+      }
+      if (j == 4 || *first != 0) {
+        printf("ERROR: %s got a fresh or uncleared area.\n", name);
+        g_errors++;
+      }
+    }
+  }
+  printf("Forked %d small tasks again.\n", forked);
+  if (forked != 4) {
+    g_errors++;
+  }
+
+  printf("--- sample16.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+/*
+  sample17.c - SFS Task Context Argument Demo
+
+  This sample demonstrates:
+    - SFS_forkArg(): one entry point, void (*)(void *), serving several
+      tasks, each called with a pointer to its own connection.
+    - No SFS_work() or SFS_otherWork() lookup on the per-tick path; the
+      work area is still there for tasks that want it.
+    - Argument tasks and plain tasks sharing the ready list in `order`.
+    - SFS_kill() from an argument task releasing only that task.
+*/
+#include <stdio.h>
+#include "sfs.h"
+
+#define CONNS 4
+#define PASSES 10
+
+struct conn {
+  int id;
+  int limit;            /* closes after this many runs, 0 = never */
+  int runs;
+};
+
+static struct conn g_conn[CONNS] = {
+  { 0, 0, 0 }, { 1, 3, 0 }, { 2, 0, 0 }, { 3, 0, 0 }
+};
+static int g_trace[CONNS + 1];
+static int g_traced = 0;
+static int g_errors = 0;
+
+void conn_task(void *arg)
+{
+  struct conn *c = arg;
+  int *seen = SFS_work();
+
+  (*seen)++;
+  c->runs++;
+  if (g_traced <= CONNS) {
+    g_trace[g_traced++] = c->id;
+  }
+  if (c->limit && c->runs == c->limit) {
+    printf("conn %d closed after %d runs.\n", c->id, c->runs);
+    SFS_kill();
+  }
+}
+
+void plain_task(void)
+{
+  if (g_traced <= CONNS) {
+    g_trace[g_traced++] = -1;
+  }
+}
+
+int main(void)
+{
+  char name[SFS_NAME_SIZE];
+  int i;
+
+  printf("--- Task Context Argument Test ---\n");
+
+  SFS_initialize();
+  for (i = 0; i < CONNS; i++) {
+    sprintf(name, "CONN%d", i);
+    if (SFS_forkArg(name, (short)(i < 2 ? 0 : 2), conn_task, &g_conn[i]) != -1) {
+      printf("ERROR: %s could not be forked.\n", name);
+      g_errors++;
+    }
+  }
+  SFS_fork("PLAIN", 1, plain_task);
+
+  for (i = 0; i < PASSES; i++) {
+    SFS_dispatch();
+  }
+
+  /* order 0 (CONN0, CONN1), order 1 (PLAIN), order 2 (CONN2, CONN3) */
+  if (g_trace[0] != 0 || g_trace[1] != 1 || g_trace[2] != -1 || g_trace[3] != 2 || g_trace[4] != 3) {
+    printf("ERROR: the first pass ran out of order.\n");
+    g_errors++;
+  }
+  for (i = 0; i < CONNS; i++) {
+    printf("conn %d ran %d times.\n", i, g_conn[i].runs);
+    if (g_conn[i].runs != (g_conn[i].limit ? g_conn[i].limit : PASSES)) {
+      g_errors++;
+    }
+  }
+  if (*(int *)SFS_otherWork("CONN3") != PASSES || SFS_otherWork("CONN1") != NULL) {
+    printf("ERROR: work areas of argument tasks are wrong.\n");
+    g_errors++;
+  }
+
+  printf("--- sample17.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
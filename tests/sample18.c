@@ -0,0 +1,137 @@
+/*
+  sample18.c - SFS Static Task Table Demo
+
+  This sample demonstrates:
+    - Listing the task set once in an X-macro and turning it into a const
+      table with SFS_TABLE().
+    - SFS_adopt() linking the whole table after SFS_initialize(); the
+      table is in dispatch order, so no entry is searched for or sorted.
+    - A warm restart (SFS_initialize() + SFS_adopt() again) producing the
+      same dispatch order.
+    - An entry out of order, and a table adopted on top of forked tasks,
+      still ending up in `order`.
+    - SFS_adopt() returning -1 like SFS_fork(), and failing with 0 once
+      the pool is exhausted, leaving none of the table behind.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "sfs.h"
+
+#define MAX_TRACE 16
+
+void sensor_task(void);
+void ctrl_task(void);
+void log_task(void);
+void late_task(void);
+
+#define APP_TASKS(X) \
+  X("SENSOR", 0, sensor_task) \
+  X("CTRL",   1, ctrl_task) \
+  X("CTRL2",  1, ctrl_task) \
+  X("LOG",    5, log_task) \
+  X("LATE",  70, late_task) \
+  X("LATER", 90, late_task)
+
+#define EXTRA_TASKS(X) \
+  X("HIGH",   3, log_task) \
+  X("EARLY",  2, sensor_task) \
+  X("LAST",  95, late_task)
+
+SFS_TABLE(app_table, APP_TASKS);
+SFS_TABLE(extra_table, EXTRA_TASKS);
+
+static char g_trace[MAX_TRACE][SFS_NAME_SIZE];
+static int g_traced = 0;
+static int g_errors = 0;
+
+/* Records the running task by matching its work area against the
+   work areas of every name the sample uses. */
+static void trace(void)
+{
+  static const char *const names[] = {
+    "SENSOR", "CTRL", "CTRL2", "LOG", "LATE", "LATER", "HIGH", "EARLY", "LAST", "FORKED"
+  };
+  void *work = SFS_work();
+  unsigned int i;
+
+  for (i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    if (SFS_otherWork((char *)names[i]) == work && g_traced < MAX_TRACE) {
+      strcpy(g_trace[g_traced++], names[i]);
+      return;
+    }
+  }
+}
+
+void sensor_task(void) { trace(); }
+void ctrl_task(void) { trace(); }
+void log_task(void) { trace(); }
+void late_task(void) { trace(); }
+
+static void check(const char *what, const char *const *expect, int n)
+{
+  int i;
+
+  printf("%s:", what);
+  for (i = 0; i < g_traced; i++) {
+    printf(" %s", g_trace[i]);
+  }
+  printf("\n");
+  if (g_traced != n) {
+    g_errors++;
+    return;
+  }
+  for (i = 0; i < n; i++) {
+    if (strcmp(g_trace[i], expect[i]) != 0) {
+      g_errors++;
+    }
+  }
+}
+
+int main(void)
+{
+  static const char *const boot[] = { "SENSOR", "CTRL", "CTRL2", "LOG", "LATE", "LATER" };
+  static const char *const mixed[] = { "FORKED", "EARLY", "HIGH", "LOG", "LAST" };
+  int restart;
+
+  printf("--- Static Task Table Test ---\n");
+
+  /* 1. Boot and two warm restarts adopt the same table */
+  for (restart = 0; restart < 3; restart++) {
+    SFS_initialize();
+    if (SFS_adopt(app_table, SFS_COUNT(app_table)) != -1) {
+      g_errors++;
+    }
+    g_traced = 0;
+    SFS_dispatch();
+    check(restart ? "restart" : "boot", boot, 6);
+  }
+
+  /* 2. Out-of-order entries on top of forked tasks */
+  SFS_initialize();
+  SFS_fork("FORKED", 0, sensor_task);
+  SFS_fork("LOG", 5, log_task);
+  if (SFS_adopt(extra_table, SFS_COUNT(extra_table)) != -1) {
+    g_errors++;
+  }
+  g_traced = 0;
+  SFS_dispatch();
+  check("mixed", mixed, 5);
+
+  /* 3. The pool holds SFS_TASK_MAX tasks: the first entries fit, the
+        rest do not, and the ones that fit are released again */
+  if (SFS_adopt(app_table, SFS_COUNT(app_table)) != 0) {
+    printf("ERROR: adopting beyond the pool should fail.\n");
+    g_errors++;
+  }
+  g_traced = 0;
+  SFS_dispatch();
+  check("after a failed adopt", mixed, 5);
+  if (SFS_fork("SPARE", 9, late_task) != -1) {
+    printf("ERROR: the TCBs of the failed adopt were not released.\n");
+    g_errors++;
+  }
+
+  printf("--- sample18.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
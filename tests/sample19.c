@@ -0,0 +1,158 @@
+/*
+  sample19.c - SFS Immediate Task Removal Demo
+
+  This sample demonstrates:
+    - SFS_kill() taking a task off the ready list in the same pass: the
+      next pass no longer visits it, and SFS_dispatch() says so at once.
+    - A reaper task stopping workers with SFS_killHandle() (no name
+      lookup) and SFS_killByName(), including the worker due right after
+      it in the current pass and one sleeping on the timing wheel.
+    - A killed task's name and work area staying readable until the end
+      of the pass, and its handle going stale after it.
+    - Killing the same task twice, or a task that does not exist, being
+      harmless.
+*/
+#include <stdio.h>
+#include "sfs.h"
+
+#define WORKERS 4
+
+static unsigned long g_clock = 0;
+static int g_runs[WORKERS + 1];
+static int g_reap_pass = -1;
+static int g_pass = 0;
+static int g_seen_dead = 0;
+static SFS_handle g_handle[WORKERS];
+static int g_errors = 0;
+
+unsigned long clock_ticks(void)
+{
+  return g_clock;
+}
+
+void once_task(void)
+{
+  g_runs[WORKERS]++;
+  SFS_kill();
+}
+
+void worker_task(void)
+{
+  int *id = SFS_work();
+
+  g_runs[*id]++;
+}
+
+void sleeper_task(void)
+{
+  int *id = SFS_work();
+
+  g_runs[*id]++;
+  SFS_sleep(1000);
+}
+
+/* Runs at order 1, right before WORK1 */
+void reaper_task(void)
+{
+  int *dead;
+
+  if (g_pass != g_reap_pass) {
+    return;
+  }
+  /* WORK1 is due next in this pass and must not run */
+  if (SFS_killHandle(g_handle[1]) != 0 || SFS_killByName("WORK2") != 0 ||
+      SFS_killHandle(g_handle[3]) != 0) {
+    g_errors++;
+  }
+  /* a second kill and an unknown name change nothing */
+  if (SFS_killByName("WORK2") != 0 || SFS_killByName("NOBODY") != -1) {
+    g_errors++;
+  }
+  dead = SFS_otherWork("WORK2");
+  g_seen_dead = (dead != NULL && *dead == 2);
+  SFS_kill();
+}
+
+int main(void)
+{
+  char name[SFS_NAME_SIZE];
+  short tcnt;
+  int i;
+
+  printf("--- Immediate Task Removal Test ---\n");
+
+  SFS_initialize();
+  SFS_timer(clock_ticks);
+  SFS_fork("ONCE", 0, once_task);
+  SFS_fork("REAPER", 1, reaper_task);
+  for (i = 0; i < WORKERS; i++) {
+    sprintf(name, "WORK%d", i);
+    if (i == 3) {
+      SFS_fork(name, 2, sleeper_task);
+    } else {
+      SFS_fork(name, 2, worker_task);
+    }
+    *(int *)SFS_otherWork(name) = i;
+    g_handle[i] = SFS_lookup(name);
+  }
+
+  /* 1. ONCE ran and is gone before the second pass */
+  tcnt = SFS_dispatch();
+  g_pass++;
+  g_clock++;
+  /* six executed plus WORK3 waiting on the wheel */
+  printf("pass 1: %d tasks\n", tcnt);
+  if (tcnt != 3 + WORKERS || SFS_otherWork("ONCE") != NULL) {
+    printf("ERROR: ONCE was not removed in its own pass.\n");
+    g_errors++;
+  }
+  tcnt = SFS_dispatch();
+  g_pass++;
+  g_clock++;
+  printf("pass 2: %d tasks\n", tcnt);
+  if (tcnt != 1 + WORKERS || g_runs[WORKERS] != 1) {
+    g_errors++;
+  }
+
+  /* 2. REAPER kills three workers, then itself */
+  g_reap_pass = g_pass;
+  tcnt = SFS_dispatch();
+  g_pass++;
+  printf("pass 3: %d tasks, runs WORK0..3: %d %d %d %d\n", tcnt,
+         g_runs[0], g_runs[1], g_runs[2], g_runs[3]);
+  if (tcnt != 2 || g_runs[0] != 3 || g_runs[1] != 2 || g_runs[2] != 2 || g_runs[3] != 1) {
+    printf("ERROR: a killed worker ran in the pass it was killed.\n");
+    g_errors++;
+  }
+  if (!g_seen_dead) {
+    printf("ERROR: WORK2's work area was gone before the end of the pass.\n");
+    g_errors++;
+  }
+  for (i = 1; i < WORKERS; i++) {
+    if (SFS_workOf(g_handle[i]) != NULL || SFS_killHandle(g_handle[i]) != -1) {
+      printf("ERROR: the handle of WORK%d is still valid.\n", i);
+      g_errors++;
+    }
+  }
+
+  /* 3. Only WORK0 is left, and its TCB slots are free again */
+  tcnt = SFS_dispatch();
+  printf("pass 4: %d tasks\n", tcnt);
+  if (tcnt != 1) {
+    g_errors++;
+  }
+  for (i = 0; i < 7; i++) {
+    sprintf(name, "NEW%d", i);
+    if (SFS_fork(name, 3, worker_task) != -1) {
+      break;
+    }
+  }
+  if (i != SFS_TASK_MAX - 1) {
+    printf("ERROR: %d TCBs were free after the kills.\n", i);
+    g_errors++;
+  }
+
+  printf("--- sample19.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
@@ -0,0 +1,174 @@
+/*
+  sample20.c - SFS Dynamic Priority Change Demo
+
+  This sample demonstrates:
+    - SFS_change() moving the running task to its new `order` as soon as
+      it returns, so the ready list stays sorted and tasks forked later
+      are still inserted in the right place.
+    - A task raised above the others running first from the next pass
+      on, and one lowered below them running last, each exactly once in
+      the pass where it changed.
+    - A lowered task being killed by name later in the same pass.
+    - A sleeping task changing its order and waking up in its new place.
+    - Ties: a task moving down joins the front of its new order, one
+      moving up joins the back, keeping it as close to its old place as
+      the sort allows.
+    - Orders past the bucket range, which share one sorted level: a
+      task forked there by a task that just changed its order is still
+      placed by the orders the others were linked with.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "sfs.h"
+
+#define MAX_TRACE 8
+
+struct shed_ws {
+  int pass;
+};
+
+static unsigned long g_clock = 0;
+static char g_trace[MAX_TRACE];
+static int g_traced = 0;
+static int g_pass = 0;
+static int g_errors = 0;
+
+unsigned long clock_ticks(void)
+{
+  return g_clock;
+}
+
+static void trace(char c)
+{
+  if (g_traced < MAX_TRACE - 1) {
+    g_trace[g_traced++] = c;
+  }
+}
+
+void a_task(void)
+{
+  trace('A');
+  if (g_pass == 10) {
+    SFS_change("A", 5, a_task);
+  }
+}
+
+void b_task(void)
+{
+  trace('B');
+}
+
+/* Load shedding: drops to the back on pass 1, comes to the front on pass 3 */
+void shed_task(void)
+{
+  trace('S');
+  if (g_pass == 1) {
+    SFS_change("SHED", 9, shed_task);
+  } else if (g_pass == 3) {
+    SFS_change("SHED", 0, shed_task);
+  }
+}
+
+void victim_task(void)
+{
+  trace('V');
+  if (g_pass == 5) {
+    SFS_change("VICTIM", 9, victim_task);
+  }
+}
+
+void killer_task(void)
+{
+  trace('K');
+  if (g_pass == 5 && SFS_killByName("VICTIM") != 0) {
+    g_errors++;
+  }
+}
+
+void nap_task(void)
+{
+  trace('N');
+  if (g_pass == 7) {
+    SFS_change("NAP", 0, nap_task);
+    SFS_sleep(2);
+  }
+}
+
+void p_task(void) { trace('P'); }
+void q_task(void) { trace('Q'); }
+void c_task(void) { trace('C'); }
+
+/* Moves out of the top level, then forks into it before returning */
+void x_task(void)
+{
+  trace('X');
+  if (g_pass == 12) {
+    SFS_change("X", 60, x_task);
+    SFS_fork("C", 77, c_task);
+  }
+}
+
+static void run(const char *expect)
+{
+  g_traced = 0;
+  SFS_dispatch();
+  g_trace[g_traced] = '\0';
+  printf("pass %d: %-6s", g_pass, g_trace);
+  if (strcmp(g_trace, expect) != 0) {
+    printf(" ERROR: expected %s", expect);
+    g_errors++;
+  }
+  printf("\n");
+  g_pass++;
+  g_clock++;
+}
+
+int main(void)
+{
+  printf("--- Dynamic Priority Change Test ---\n");
+
+  SFS_initialize();
+  SFS_timer(clock_ticks);
+  SFS_fork("A", 2, a_task);
+  SFS_fork("SHED", 3, shed_task);
+  SFS_fork("B", 4, b_task);
+
+  run("ASB");
+  run("ASB");   /* SHED drops to 9: not run twice */
+  run("ABS");
+  run("ABS");   /* SHED rises to 0 */
+  run("SAB");
+
+  /* A task forked at order 5 still lands between B and the end */
+  SFS_fork("VICTIM", 1, victim_task);
+  SFS_fork("KILLER", 5, killer_task);
+  run("SVABK"); /* VICTIM drops to 9, KILLER removes it on the way */
+  run("SABK");
+
+  SFS_fork("NAP", 6, nap_task);
+  run("SABKN"); /* NAP moves to 0 and sleeps two ticks */
+  run("SABK");
+  run("SNABK"); /* behind SHED, which has order 0 too */
+
+  /* Moving down, A joins the front of order 5, ahead of KILLER */
+  run("SNABK");
+  run("SNBAK");
+
+  /* The top level (order 63 and up) is sorted by walking it: X still
+     sits at 83 until it returns, so C (77) goes in front of P (78) */
+  SFS_killByName("SHED");
+  SFS_killByName("NAP");
+  SFS_killByName("A");
+  SFS_killByName("B");
+  SFS_killByName("KILLER");
+  SFS_fork("P", 78, p_task);
+  SFS_fork("X", 83, x_task);
+  SFS_fork("Q", 88, q_task);
+  run("PXQ");   /* X moves to 60 and forks C */
+  run("XCPQ");
+  run("XCPQ");
+
+  printf("--- sample20.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+/*
+  sample21.c - SFS Bounded Dispatch Demo
+
+  This sample demonstrates:
+    - SFS_dispatchFor() running a pass only until a budget of timer
+      ticks is spent, so the main loop can poll I/O between chunks.
+    - A pass cut short returning -1 and the next call resuming with the
+      task that was due next: every task runs once per pass, in order.
+    - At least one task running per call, even with a budget of 0.
+    - A task killed between two chunks of a pass not running again.
+    - SFS_ctxDispatchFor() without a timer, counting tasks instead.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "sfs.h"
+
+#define TASKS 6
+#define COST 10
+#define HEAVY_COST 40
+#define BUDGET 25
+#define PASSES 20
+#define MAX_TRACE 16
+
+static unsigned long g_clock = 0;
+static int g_runs[TASKS];
+static char g_trace[MAX_TRACE];
+static int g_traced = 0;
+static int g_errors = 0;
+
+unsigned long clock_ticks(void)
+{
+  return g_clock;
+}
+
+static void trace(char c)
+{
+  if (g_traced < MAX_TRACE - 1) {
+    g_trace[g_traced++] = c;
+  }
+}
+
+/* Each task burns COST ticks of the fake free-running counter */
+void work_task(void *arg)
+{
+  int id = *(int *)arg;
+
+  g_runs[id]++;
+  trace((char)('0' + id));
+  g_clock += id == TASKS - 1 ? HEAVY_COST : COST;
+}
+
+/* One call of SFS_dispatchFor(), traced */
+static short chunk(unsigned long budget, const char *expect)
+{
+  short ret;
+
+  g_traced = 0;
+  ret = SFS_dispatchFor(budget);
+  g_trace[g_traced] = '\0';
+  printf("  chunk %-4s -> %d\n", g_trace, ret);
+  if (strcmp(g_trace, expect) != 0) {
+    printf("  ERROR: expected %s\n", expect);
+    g_errors++;
+  }
+  return ret;
+}
+
+void count_task(void *arg)
+{
+  (*(int *)arg)++;
+}
+
+int main(void)
+{
+  static int ids[TASKS] = { 0, 1, 2, 3, 4, 5 };
+  static SFS_ctx ctx;
+  static struct SFS_tg pool[4];
+  static SFS_ARENA(arena, 4, SFS_WORK_SIZE);
+  char name[SFS_NAME_SIZE];
+  unsigned long last, gap, worst = 0;
+  int i, polls = 0, counts[3] = { 0, 0, 0 };
+  short ret;
+
+  printf("--- Bounded Dispatch Test ---\n");
+
+  SFS_initialize();
+  SFS_timer(clock_ticks);
+  for (i = 0; i < TASKS; i++) {
+    sprintf(name, "T%d", i);
+    SFS_forkArg(name, (short)i, work_task, &ids[i]);
+  }
+
+  /* 1. Three tasks fit in 25 ticks; the pass ends on the second call */
+  printf("budget %d:\n", BUDGET);
+  if (chunk(BUDGET, "012") != -1 || chunk(BUDGET, "345") != TASKS) {
+    g_errors++;
+  }
+
+  /* 2. A budget of 0 still runs one task per call */
+  printf("budget 0:\n");
+  chunk(0, "0");
+  chunk(0, "1");
+
+  /* 3. T3 is still due in this pass; killed between chunks, it must not run */
+  if (SFS_killByName("T3") != 0 || SFS_killByName("T1") != 0) {
+    g_errors++;
+  }
+  printf("T1 and T3 killed:\n");
+  if (chunk(BUDGET, "245") != 5) {  /* T0 and T1 ran in earlier chunks */
+    g_errors++;
+  }
+  if (SFS_otherWork("T3") != NULL || SFS_otherWork("T1") != NULL) {
+    printf("ERROR: killed tasks are still there.\n");
+    g_errors++;
+  }
+  chunk(BUDGET, "024");
+  chunk(BUDGET, "5");
+
+  /* 4. I/O polled between chunks: no gap is longer than the budget
+        plus the longest task */
+  memset(g_runs, 0, sizeof(g_runs));
+  last = g_clock;
+  for (i = 0; i < PASSES; ) {
+    ret = SFS_dispatchFor(BUDGET);
+    gap = g_clock - last;
+    last = g_clock;
+    if (gap > worst) {
+      worst = gap;
+    }
+    polls++;
+    if (ret != -1) {
+      i++;
+    }
+  }
+  printf("%d passes in %d chunks, longest gap between polls %lu ticks.\n", PASSES, polls, worst);
+  if (worst >= BUDGET + HEAVY_COST) {
+    g_errors++;
+  }
+  for (i = 0; i < TASKS; i++) {
+    if (g_runs[i] != (i == 1 || i == 3 ? 0 : PASSES)) {
+      printf("ERROR: T%d ran %d times.\n", i, g_runs[i]);
+      g_errors++;
+    }
+  }
+
+  /* 5. Without a timer the budget counts tasks */
+  SFS_ctxInitialize(&ctx, pool, 4);
+  SFS_ctxArena(&ctx, arena, sizeof(arena));
+  for (i = 0; i < 3; i++) {
+    sprintf(name, "C%d", i);
+    SFS_ctxForkArg(&ctx, name, 0, count_task, &counts[i]);
+  }
+  ret = SFS_ctxDispatchFor(&ctx, 2);
+  printf("no timer, budget 2: %d %d %d -> %d\n", counts[0], counts[1], counts[2], ret);
+  if (ret != -1 || counts[0] != 1 || counts[1] != 1 || counts[2] != 0) {
+    g_errors++;
+  }
+  ret = SFS_ctxDispatchFor(&ctx, 2);
+  if (ret != 3 || counts[2] != 1) {
+    g_errors++;
+  }
+
+  printf("--- sample21.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+/*
+  sample22.c - SFS Earliest Deadline First Demo
+
+  This sample demonstrates:
+    - SFS_policy() switching the default instance to SFS_POLICY_EDF,
+      with the ready heap in a static array.
+    - SFS_deadline() giving tasks relative deadlines: each pass runs the
+      ready tasks by absolute deadline, whatever their `order`.
+    - A task waking up from SFS_sleep() due a few ticks after its wake
+      tick, ahead of tasks that have been ready since the last pass.
+    - A periodic task taking its period as its deadline.
+    - A task killed from the heap during a pass, and a deadline changed
+      while the task waits in the heap.
+    - SFS_policy() refusing a heap that is too small, and being refused
+      once tasks are ready.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "sfs.h"
+
+#define MAX_TRACE 8
+
+static unsigned long g_clock = 0;
+static struct SFS_tg *g_heap[SFS_TASK_MAX];
+static char g_trace[MAX_TRACE];
+static int g_traced = 0;
+static int g_pass = 0;
+static int g_errors = 0;
+
+unsigned long clock_ticks(void)
+{
+  return g_clock;
+}
+
+static void trace(char c)
+{
+  if (g_traced < MAX_TRACE - 1) {
+    g_trace[g_traced++] = c;
+  }
+}
+
+void a_task(void) { trace('A'); }
+void b_task(void) { trace('B'); }
+void c_task(void) { trace('C'); }
+void p_task(void) { trace('P'); }
+
+/* Sleeps 3 ticks after every run */
+void d_task(void)
+{
+  trace('D');
+  SFS_sleep(3);
+}
+
+/* Kills C, which is still waiting in the heap, on its first run */
+void k_task(void)
+{
+  trace('K');
+  if (g_pass == 7 && SFS_killByName("C") != 0) {
+    g_errors++;
+  }
+}
+
+static void run(const char *expect)
+{
+  g_traced = 0;
+  SFS_dispatch();
+  g_trace[g_traced] = '\0';
+  printf("pass %d at tick %2lu: %-6s", g_pass, g_clock, g_trace);
+  if (strcmp(g_trace, expect) != 0) {
+    printf(" ERROR: expected %s", expect);
+    g_errors++;
+  }
+  printf("\n");
+  g_pass++;
+  g_clock++;
+}
+
+int main(void)
+{
+  printf("--- Earliest Deadline First Test ---\n");
+
+  SFS_initialize();
+  SFS_timer(clock_ticks);
+  if (SFS_policy(SFS_POLICY_EDF, g_heap, SFS_TASK_MAX - 1) != -1) {
+    printf("ERROR: a heap smaller than the pool was accepted.\n");
+    g_errors++;
+  }
+  if (SFS_policy(SFS_POLICY_EDF, g_heap, SFS_TASK_MAX) != 0) {
+    g_errors++;
+  }
+
+  /* 1. Deadlines, not orders, decide: B (10) C (30) A (50) */
+  SFS_fork("A", 0, a_task);
+  SFS_fork("B", 1, b_task);
+  SFS_fork("C", 2, c_task);
+  SFS_deadline("A", 50);
+  SFS_deadline("B", 10);
+  SFS_deadline("C", 30);
+  if (SFS_policy(SFS_POLICY_ORDER, NULL, 0) != -1) {
+    printf("ERROR: the policy changed with tasks ready.\n");
+    g_errors++;
+  }
+  run("BCA");
+  run("BCA");
+
+  /* 2. D is due 5 ticks after it wakes, ahead of B (9 ticks left) */
+  SFS_fork("D", 3, d_task);
+  SFS_deadline("D", 5);
+  run("DBCA");  /* tick 2, D sleeps until 5 */
+  run("BCA");
+  run("BCA");
+  run("DBCA");  /* tick 5 */
+
+  /* 3. P runs every 20 ticks and is due 20 ticks after each release,
+        between B (due at 15) and C (due at 35) */
+  SFS_forkPeriodic("P", 4, p_task, 20);
+  run("BPCA");  /* tick 6 */
+
+  /* 4. K, due one tick after each release, kills C out of the heap */
+  SFS_fork("K", 5, k_task);
+  SFS_deadline("K", 1);
+  run("KBA");   /* tick 7 */
+  if (SFS_otherWork("C") != NULL) {
+    g_errors++;
+  }
+  run("KDBA");  /* tick 8: D is back, due at 13 */
+
+  /* 5. A waits in the heap due at 58; its new deadline of 1 makes it
+        due at 9, level with K, and the lower order goes first */
+  SFS_deadline("A", 1);
+  run("AKB");   /* tick 9 */
+
+  printf("--- sample22.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+/*
+  sample23.c - SFS Dispatch Trace Demo
+
+  This sample demonstrates:
+    - Building sfs.c with -DSFS_TRACE (see the Makefile, which links this
+      sample against the sfs_trace.o variant).
+    - SFS_trace() recording fork, dispatch, change and kill events as
+      fixed-size binary records in a static ring, stamped by an injected
+      clock (here a simulated cycle counter).
+    - The ring overwriting its oldest records, and SFS_traceRead()
+      returning the newest ones, oldest first.
+    - Writing a dump (sample23.sfst) that tools/sfs_trace2json turns
+      into Chrome/Perfetto trace JSON; the Makefile runs it.
+*/
+#include <stdio.h>
+#include "sfs.h"
+
+#define RING 16
+#define PASSES 10
+
+static unsigned long g_cycles = 0;
+static SFS_event g_ring[RING];
+static SFS_event g_out[RING];
+static int g_pass = 0;
+static int g_errors = 0;
+
+unsigned long cycle_counter(void)
+{
+  return g_cycles;
+}
+
+void sensor_task(void)
+{
+  g_cycles += 3;
+}
+
+/* Becomes the filter after the first pass */
+void boot_task(void)
+{
+  g_cycles += 20;
+  SFS_change("FILTER", 1, sensor_task);
+}
+
+/* Kills SENSOR on pass 4, itself on pass 5 */
+void reaper_task(void)
+{
+  g_cycles += 1;
+  if (g_pass == 4) {
+    SFS_killByName("SENSOR");
+  } else if (g_pass == 5) {
+    SFS_kill();
+  }
+}
+
+static unsigned long read_all(void)
+{
+  unsigned long n = SFS_traceRead(g_out, RING);
+  unsigned long i;
+
+  for (i = 0; i < n; i++) {
+    printf("  %-8s %-8s %4lu..%-4lu\n", SFS_traceName(g_out[i].task),
+           g_out[i].type == SFS_EV_DISPATCH ? "dispatch" :
+           g_out[i].type == SFS_EV_FORK ? "fork" :
+           g_out[i].type == SFS_EV_KILL ? "kill" : "change",
+           g_out[i].start, g_out[i].end);
+    /* written as they end: a task's kills come before its dispatch */
+    if (i > 0 && g_out[i].end < g_out[i - 1].end) {
+      printf("ERROR: records out of order.\n");
+      g_errors++;
+    }
+  }
+  return n;
+}
+
+static void dump(const char *path)
+{
+  FILE *fp = fopen(path, "wb");
+  unsigned long records, names = SFS_TASK_MAX;
+  unsigned int i;
+
+  if (fp == NULL) {
+    g_errors++;
+    return;
+  }
+  records = SFS_traceRead(g_out, RING);
+  fwrite("SFST", 1, 4, fp);
+  fwrite(&records, sizeof(records), 1, fp);
+  fwrite(&names, sizeof(names), 1, fp);
+  fwrite(g_out, sizeof(SFS_event), records, fp);
+  for (i = 0; i < names; i++) {
+    fwrite(SFS_traceName(i), SFS_NAME_SIZE, 1, fp);
+  }
+  fclose(fp);
+  printf("%lu records written to %s.\n", records, path);
+}
+
+int main(void)
+{
+  unsigned long n, i;
+  int kills;
+
+  printf("--- Dispatch Trace Test ---\n");
+
+  SFS_initialize();
+  if (SFS_trace(g_ring, 12, cycle_counter) != -1) {
+    printf("ERROR: a ring of 12 entries was accepted.\n");
+    g_errors++;
+  }
+  SFS_trace(g_ring, RING, cycle_counter);
+
+  /* 1. Three forks and one pass: 3 fork, 3 dispatch and 1 change record;
+        BOOT's change is written before its own dispatch record */
+  SFS_fork("SENSOR", 0, sensor_task);
+  SFS_fork("BOOT", 1, boot_task);
+  SFS_fork("REAPER", 2, reaper_task);
+  SFS_dispatch();
+  g_pass++;
+  printf("first pass:\n");
+  n = read_all();
+  if (n != 7 || g_out[3].type != SFS_EV_DISPATCH || g_out[3].end - g_out[3].start != 3 ||
+      g_out[4].type != SFS_EV_CHANGE || g_out[5].end - g_out[5].start != 20) {
+    printf("ERROR: unexpected first pass records.\n");
+    g_errors++;
+  }
+
+  /* 2. More records than the ring holds: only the newest 16 are kept,
+        including the two kills */
+  for (; g_pass < PASSES; g_pass++) {
+    SFS_dispatch();
+  }
+  printf("last %d records:\n", RING);
+  n = read_all();
+  for (kills = 0, i = 0; i < n; i++) {
+    kills += g_out[i].type == SFS_EV_KILL;
+  }
+  if (n != RING || kills != 2 || g_out[RING - 1].type != SFS_EV_DISPATCH) {
+    g_errors++;
+  }
+  if (SFS_traceRead(g_out, RING) != 0) {
+    printf("ERROR: records were read twice.\n");
+    g_errors++;
+  }
+
+  /* 3. A fresh pass for the host-side converter */
+  SFS_fork("SENSOR", 0, sensor_task);
+  SFS_dispatch();
+  dump("sample23.sfst");
+
+  printf("--- sample23.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
@@ -0,0 +1,202 @@
+/*
+  sample24.c - SFS Request Queue Demo
+
+  This sample demonstrates:
+    - SFS_queueInit() without a compare-and-swap: a single producer,
+      here a simulated interrupt handler, posting to the default
+      instance through SFS_listen().
+    - SFS_postWake() making a sleeping task run in the next pass, long
+      before its wake tick; SFS_postKill() and SFS_postFork() carried
+      out at the start of the next pass as well.
+    - A post to a full queue failing instead of blocking, and requests
+      that cannot be carried out counted in `failed`.
+    - Four pthreads posting forks to one instance at once through a
+      queue with an injected compare-and-swap, every task running
+      exactly once.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "sfs.h"
+
+#define SLOTS 4
+#define MAX_TRACE 8
+#define PRODUCERS 4
+#define POSTS 2000
+#define MT_SLOTS 16
+#define MT_POOL 64
+
+static unsigned long g_clock = 0;
+static SFS_cmd g_slot[SLOTS];
+static SFS_queue g_queue;
+static char g_trace[MAX_TRACE];
+static int g_traced = 0;
+static int g_errors = 0;
+
+static SFS_ctx g_ctx;
+static struct SFS_tg g_pool[MT_POOL];
+static SFS_ARENA(g_arena, MT_POOL, SFS_WORK_SIZE);
+static SFS_cmd g_mtSlot[MT_SLOTS];
+static SFS_queue g_mtQueue;
+static long g_runs[PRODUCERS];
+
+unsigned long clock_ticks(void)
+{
+  return g_clock;
+}
+
+static void trace(char c)
+{
+  if (g_traced < MAX_TRACE - 1) {
+    g_trace[g_traced++] = c;
+  }
+}
+
+/* Sleeps until the next byte arrives */
+void rx_task(void)
+{
+  trace('R');
+  SFS_sleep(100);
+}
+
+void main_task(void) { trace('M'); }
+void late_task(void) { trace('L'); }
+
+static void run(const char *expect)
+{
+  g_traced = 0;
+  SFS_dispatch();
+  g_trace[g_traced] = '\0';
+  printf("tick %lu: %-4s", g_clock, g_trace);
+  if (strcmp(g_trace, expect) != 0) {
+    printf(" ERROR: expected %s", expect);
+    g_errors++;
+  }
+  printf("\n");
+  g_clock++;
+}
+
+int cas(volatile unsigned long *p, unsigned long expect, unsigned long value)
+{
+  return __sync_bool_compare_and_swap(p, expect, value);
+}
+
+void fence(void)
+{
+  __sync_synchronize();
+}
+
+/* One task per post; each removes itself after its only run */
+static void count_run(int producer)
+{
+  g_runs[producer]++;
+  SFS_ctxKill(&g_ctx);
+}
+
+void worker0(void) { count_run(0); }
+void worker1(void) { count_run(1); }
+void worker2(void) { count_run(2); }
+void worker3(void) { count_run(3); }
+
+static void (*const g_worker[PRODUCERS])(void) = { worker0, worker1, worker2, worker3 };
+
+void *producer_main(void *arg)
+{
+  int id = *(int *)arg;
+  long i;
+
+  for (i = 0; i < POSTS; i++) {
+    while (SFS_postFork(&g_mtQueue, "W", (short)id, g_worker[id]) != 0) {
+      /* full: the dispatcher catches up */
+    }
+  }
+  return NULL;
+}
+
+int main(void)
+{
+  static int ids[PRODUCERS] = { 0, 1, 2, 3 };
+  pthread_t th[PRODUCERS];
+  SFS_handle rx, main_h;
+  long total;
+  int i;
+
+  printf("--- Request Queue Test ---\n");
+
+  SFS_initialize();
+  SFS_timer(clock_ticks);
+  if (SFS_queueInit(&g_queue, g_slot, 3, NULL, NULL) != -1) {
+    printf("ERROR: a queue of 3 slots was accepted.\n");
+    g_errors++;
+  }
+  SFS_queueInit(&g_queue, g_slot, SLOTS, NULL, NULL);
+  SFS_listen(&g_queue);
+
+  SFS_fork("RX", 0, rx_task);
+  SFS_fork("MAIN", 1, main_task);
+  rx = SFS_lookup("RX");
+  main_h = SFS_lookup("MAIN");
+
+  /* 1. RX sleeps for 100 ticks; the "interrupt" wakes it early */
+  run("RM");
+  run("M");
+  SFS_postWake(&g_queue, rx);
+  run("RM");
+  run("M");
+
+  /* 2. Kill and fork requests from the handler */
+  SFS_postKill(&g_queue, main_h);
+  SFS_postFork(&g_queue, "LATE", 2, late_task);
+  run("L");
+
+  /* 3. A full queue refuses the fifth post; a stale handle fails later */
+  for (i = 0; i < SLOTS; i++) {
+    if (SFS_postWake(&g_queue, i == 0 ? main_h : rx) != 0) {
+      g_errors++;
+    }
+  }
+  if (SFS_postWake(&g_queue, rx) != -1) {
+    printf("ERROR: a post to a full queue succeeded.\n");
+    g_errors++;
+  }
+  run("RL");
+  printf("failed requests: %lu\n", g_queue.failed);
+  if (g_queue.failed != 1) {
+    g_errors++;
+  }
+
+  /* 4. Four producers, one dispatcher, no locks */
+  SFS_ctxInitialize(&g_ctx, g_pool, MT_POOL);
+  SFS_ctxArena(&g_ctx, g_arena, sizeof(g_arena));
+  SFS_queueInit(&g_mtQueue, g_mtSlot, MT_SLOTS, cas, fence);
+  SFS_ctxListen(&g_ctx, &g_mtQueue);
+  for (i = 0; i < PRODUCERS; i++) {
+    pthread_create(&th[i], NULL, producer_main, &ids[i]);
+  }
+  do {
+    SFS_ctxDispatch(&g_ctx);
+    for (total = 0, i = 0; i < PRODUCERS; i++) {
+      total += g_runs[i];
+    }
+  } while (total < PRODUCERS * POSTS);
+  for (i = 0; i < PRODUCERS; i++) {
+    pthread_join(th[i], NULL);
+  }
+  SFS_ctxDispatch(&g_ctx);
+
+  printf("%d producers: %ld %ld %ld %ld runs, %lu failed\n", PRODUCERS,
+         g_runs[0], g_runs[1], g_runs[2], g_runs[3], g_mtQueue.failed);
+  for (i = 0; i < PRODUCERS; i++) {
+    if (g_runs[i] != POSTS) {
+      printf("ERROR: producer %d: %ld runs.\n", i, g_runs[i]);
+      g_errors++;
+    }
+  }
+  if (g_mtQueue.failed != 0 || SFS_ctxOtherWork(&g_ctx, "W") != NULL) {
+    g_errors++;
+  }
+
+  printf("--- sample24.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
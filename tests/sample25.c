@@ -0,0 +1,270 @@
+/*
+  sample25.c - SFS Suspend and Resume Demo
+
+  This sample demonstrates:
+    - SFS_suspend()/SFS_resume() pausing a task without killing it: it
+      keeps its work area, and the pass skips it without visiting it.
+    - A task suspending itself, running to the end of that run first.
+    - A sleeping task suspended and resumed before its wake tick still
+      waking on time; one resumed after it running at once.
+    - SFS_group() and SFS_suspendGroup()/SFS_resumeGroup() pausing and
+      restarting a group of tasks in one call.
+    - Killing a suspended task.
+    - A task that already ran being suspended and resumed later in the
+      same pass, after lowering its order or not, under either policy:
+      it does not run a second time in that pass.
+    - An instance with many dormant tasks, where SFS_ctxDispatch()
+      reports only the few that are awake, and suspension under
+      SFS_POLICY_EDF.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "sfs.h"
+
+#define MAX_TRACE 8
+#define DORMANT_POOL 256
+#define AWAKE 6
+
+struct count_ws {
+  int runs;
+};
+
+static unsigned long g_clock = 0;
+static char g_trace[MAX_TRACE];
+static int g_traced = 0;
+static int g_errors = 0;
+static int g_lower = 0;
+static int g_juggle = 0;
+
+static SFS_ctx g_ctx;
+static struct SFS_tg g_pool[DORMANT_POOL];
+static SFS_ARENA(g_arena, DORMANT_POOL, SFS_WORK_SIZE);
+static struct SFS_tg *g_heap[DORMANT_POOL];
+static long g_dormantRuns = 0;
+
+unsigned long clock_ticks(void)
+{
+  return g_clock;
+}
+
+static void trace(char c)
+{
+  if (g_traced < MAX_TRACE - 1) {
+    g_trace[g_traced++] = c;
+  }
+}
+
+void a_task(void) { trace('A'); }
+
+/* Counts its runs in its work area, which survives a suspension */
+void b_task(void)
+{
+  struct count_ws *ws = SFS_work();
+
+  ws->runs++;
+  trace('B');
+}
+
+/* Suspends itself on its third run */
+void c_task(void)
+{
+  struct count_ws *ws = SFS_work();
+
+  trace('C');
+  if (++ws->runs == 3) {
+    SFS_suspend("C");
+  }
+}
+
+/* Sleeps 4 ticks after every run */
+void d_task(void)
+{
+  trace('D');
+  SFS_sleep(4);
+}
+
+/* Drops to order 72 when asked */
+void e_task(void)
+{
+  trace('E');
+  if (g_lower) {
+    g_lower = 0;
+    SFS_change("E", 72, e_task);
+  }
+}
+
+/* Suspends and resumes E, which ran before it, when asked */
+void f_task(void)
+{
+  trace('F');
+  if (g_juggle) {
+    g_juggle = 0;
+    SFS_suspend("E");
+    SFS_resume("E");
+  }
+}
+
+void g_task(void) { trace('G'); }
+void h_task(void) { trace('H'); }
+
+static void run(const char *expect)
+{
+  g_traced = 0;
+  SFS_dispatch();
+  g_trace[g_traced] = '\0';
+  printf("tick %2lu: %-6s", g_clock, g_trace);
+  if (strcmp(g_trace, expect) != 0) {
+    printf(" ERROR: expected %s", expect);
+    g_errors++;
+  }
+  printf("\n");
+  g_clock++;
+}
+
+void dormant_task(void)
+{
+  g_dormantRuns++;
+}
+
+void juggle_task(void)
+{
+  SFS_ctxSuspend(&g_ctx, "T8");
+  SFS_ctxResume(&g_ctx, "T8");
+}
+
+int main(void)
+{
+  struct count_ws *ws;
+  char name[SFS_NAME_SIZE];
+  short ret;
+  int i;
+
+  printf("--- Suspend and Resume Test ---\n");
+
+  SFS_initialize();
+  SFS_timer(clock_ticks);
+  SFS_fork("A", 0, a_task);
+  SFS_fork("B", 1, b_task);
+  SFS_fork("C", 2, c_task);
+  if (SFS_suspend("NONE") != -1 || SFS_resume("NONE") != -1) {
+    g_errors++;
+  }
+
+  /* 1. B is paused and picks up its count where it left off */
+  run("ABC");
+  SFS_suspend("B");
+  SFS_suspend("B");   /* twice is the same as once */
+  run("AC");
+  run("AC");          /* C suspends itself on this run */
+  run("A");
+  SFS_resume("B");
+  run("AB");
+  ws = SFS_otherWork("B");
+  if (ws == NULL || ws->runs != 2) {
+    printf("ERROR: B lost its work area.\n");
+    g_errors++;
+  }
+  SFS_resume("C");
+  run("ABC");
+
+  /* 2. D sleeps 4 ticks; resumed before its wake tick it still waits */
+  SFS_fork("D", 3, d_task);
+  run("ABCD");        /* tick 6, D wakes at 10 */
+  SFS_suspend("D");
+  run("ABC");
+  SFS_resume("D");
+  run("ABC");
+  run("ABC");
+  run("ABCD");        /* tick 10, D wakes at 14 */
+  SFS_suspend("D");
+  for (i = 0; i < 5; i++) {
+    run("ABC");       /* tick 14 goes by while D is suspended */
+  }
+  SFS_resume("D");
+  run("ABCD");        /* tick 16: overdue, runs at once */
+
+  /* 3. Groups */
+  SFS_fork("G", 4, g_task);
+  SFS_fork("H", 5, h_task);
+  SFS_group("G", 0x01);
+  SFS_group("H", 0x03);
+  SFS_group("A", 0x02);
+  if (SFS_suspendGroup(0x01) != 2) {
+    g_errors++;
+  }
+  run("ABC");
+  if (SFS_suspendGroup(0x02) != 1 || SFS_resumeGroup(0x01) != 2) {
+    g_errors++;
+  }
+  run("BCGH");        /* H resumed with group 1, though group 2 is paused */
+  SFS_resumeGroup(0x02);
+  run("ABCGH");
+
+  /* 4. A suspended task can be killed */
+  SFS_suspend("G");
+  if (SFS_killByName("G") != 0 || SFS_otherWork("G") != NULL) {
+    g_errors++;
+  }
+  run("ABCDH");       /* tick 20, D is due again */
+
+  /* 5. Suspended and resumed after running, it waits for the next pass */
+  SFS_fork("E", 14, e_task);
+  SFS_fork("F", 14, f_task);
+  run("ABCHEF");
+  g_juggle = 1;
+  run("ABCHEF");      /* E is not run again behind F */
+  run("ABCHEF");
+  g_lower = 1;
+  g_juggle = 1;
+  run("ABCDHEF");     /* tick 24: E drops to 72 and is juggled */
+  run("ABCHFE");
+
+  /* 6. Many dormant tasks cost nothing on a pass */
+  SFS_ctxInitialize(&g_ctx, g_pool, DORMANT_POOL);
+  SFS_ctxArena(&g_ctx, g_arena, sizeof(g_arena));
+  for (i = 0; i < DORMANT_POOL; i++) {
+    sprintf(name, "T%d", i);
+    SFS_ctxFork(&g_ctx, name, (short)(i % 32), dormant_task);
+    SFS_ctxGroup(&g_ctx, name, i < AWAKE ? 0x01 : 0x02);
+  }
+  SFS_ctxSuspendGroup(&g_ctx, 0x02);
+  ret = SFS_ctxDispatch(&g_ctx);
+  printf("%d tasks, %d awake: %d ran\n", DORMANT_POOL, AWAKE, ret);
+  if (ret != AWAKE || g_dormantRuns != AWAKE) {
+    g_errors++;
+  }
+  if (SFS_ctxResumeGroup(&g_ctx, 0x02) != DORMANT_POOL - AWAKE ||
+      SFS_ctxDispatch(&g_ctx) != DORMANT_POOL) {
+    g_errors++;
+  }
+
+  /* 7. Under EDF a suspended task leaves the heap */
+  SFS_ctxSuspendGroup(&g_ctx, 0x03);
+  if (SFS_ctxPolicy(&g_ctx, SFS_POLICY_EDF, g_heap, DORMANT_POOL) != 0) {
+    printf("ERROR: tasks were still ready.\n");
+    g_errors++;
+  }
+  SFS_ctxResume(&g_ctx, "T7");
+  SFS_ctxResume(&g_ctx, "T8");
+  SFS_ctxSuspend(&g_ctx, "T7");
+  g_dormantRuns = 0;
+  ret = SFS_ctxDispatch(&g_ctx);
+  if (ret != 1 || g_dormantRuns != 1) {
+    printf("ERROR: EDF ran %d tasks.\n", ret);
+    g_errors++;
+  }
+
+  /* 8. Deferred under EDF, suspended and resumed: still once a pass */
+  SFS_ctxKillByName(&g_ctx, "T9");
+  SFS_ctxFork(&g_ctx, "JUGGLE", 31, juggle_task);
+  g_dormantRuns = 0;
+  ret = SFS_ctxDispatch(&g_ctx);
+  if (ret != 2 || g_dormantRuns != 1) {
+    printf("ERROR: T8 ran %ld times in one EDF pass.\n", g_dormantRuns);
+    g_errors++;
+  }
+
+  printf("--- sample25.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
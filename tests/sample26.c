@@ -0,0 +1,158 @@
+/*
+  sample26.c - SFS Mailbox Demo
+
+  This sample demonstrates:
+    - SFS_mailbox() giving a task a fixed ring of message pointers, and
+      the task not being dispatched while the ring is empty.
+    - SFS_send() from another task and from outside a pass, and
+      SFS_recv() handing over the very same pointer: no copy.
+    - A consumer that reads one message per run staying ready while
+      mail is left, and going back to waiting once SFS_recv() returns
+      NULL.
+    - A full mailbox, a task without one and a stale handle refusing
+      SFS_send().
+    - A suspended task collecting mail but only running once resumed.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "sfs.h"
+
+#define MAX_TRACE 8
+#define MAIL_SLOTS 4
+
+struct frame {
+  int seq;
+  char text[8];
+};
+
+static struct frame g_frames[MAIL_SLOTS + 1];
+static void *g_mail[MAIL_SLOTS];
+static SFS_handle g_consumer;
+static char g_trace[MAX_TRACE];
+static int g_traced = 0;
+static int g_pass = 0;
+static int g_next = 0;
+static int g_errors = 0;
+
+static void trace(char c)
+{
+  if (g_traced < MAX_TRACE - 1) {
+    g_trace[g_traced++] = c;
+  }
+}
+
+/* Sends a frame on passes 1 and 2, two on pass 4 */
+void producer_task(void)
+{
+  int n = g_pass == 1 || g_pass == 2 ? 1 : g_pass == 4 ? 2 : 0;
+
+  trace('P');
+  for (; n > 0; n--) {
+    if (SFS_send(g_consumer, &g_frames[g_next++]) != 0) {
+      g_errors++;
+    }
+  }
+}
+
+/* Handles one frame per run */
+void consumer_task(void)
+{
+  struct frame *f = SFS_recv();
+
+  if (f == NULL) {
+    trace('-');
+    return;
+  }
+  trace((char)('0' + f->seq));
+  if (f != &g_frames[f->seq]) {
+    printf("ERROR: frame %d was copied.\n", f->seq);
+    g_errors++;
+  }
+}
+
+void idle_task(void) { trace('I'); }
+
+static void run(const char *expect)
+{
+  g_traced = 0;
+  SFS_dispatch();
+  g_trace[g_traced] = '\0';
+  printf("pass %d: %-6s", g_pass, g_trace);
+  if (strcmp(g_trace, expect) != 0) {
+    printf(" ERROR: expected %s", expect);
+    g_errors++;
+  }
+  printf("\n");
+  g_pass++;
+}
+
+int main(void)
+{
+  int i;
+
+  printf("--- Mailbox Test ---\n");
+
+  for (i = 0; i <= MAIL_SLOTS; i++) {
+    g_frames[i].seq = i;
+    sprintf(g_frames[i].text, "frame%d", i);
+  }
+
+  SFS_initialize();
+  SFS_fork("PRODUCER", 0, producer_task);
+  SFS_fork("CONSUMER", 1, consumer_task);
+  SFS_fork("IDLE", 2, idle_task);
+  if (SFS_mailbox("CONSUMER", g_mail, 3) != -1) {
+    printf("ERROR: a mailbox of 3 slots was accepted.\n");
+    g_errors++;
+  }
+  SFS_mailbox("CONSUMER", g_mail, MAIL_SLOTS);
+  g_consumer = SFS_lookup("CONSUMER");
+  if (SFS_send(SFS_lookup("IDLE"), &g_frames[0]) != -1) {
+    printf("ERROR: a task without a mailbox got mail.\n");
+    g_errors++;
+  }
+
+  /* 1. The consumer runs only once there is mail; it sees the empty
+        mailbox on the run after its last frame and waits again */
+  run("PI");
+  run("P0I");   /* sent on the way, consumer comes after the producer */
+  run("P1I");
+  run("P-I");
+  run("P2I");   /* two frames: one handled per run */
+  run("P3I");
+  run("P-I");
+  run("PI");
+
+  /* 2. Sent from outside a pass; a full mailbox refuses the fifth */
+  g_next = 0;
+  for (i = 0; i < MAIL_SLOTS; i++) {
+    SFS_send(g_consumer, &g_frames[g_next++]);
+  }
+  if (SFS_send(g_consumer, &g_frames[MAIL_SLOTS]) != -1) {
+    printf("ERROR: a full mailbox took a frame.\n");
+    g_errors++;
+  }
+  run("P0I");
+
+  /* 3. Suspended, it keeps collecting mail but does not run */
+  SFS_suspend("CONSUMER");
+  SFS_send(g_consumer, &g_frames[MAIL_SLOTS]);
+  run("PI");
+  SFS_resume("CONSUMER");
+  run("P1I");
+  run("P2I");
+  run("P3I");
+  run("P4I");
+  run("P-I");
+
+  /* 4. Killed, its handle no longer takes mail */
+  SFS_killByName("CONSUMER");
+  if (SFS_send(g_consumer, &g_frames[0]) != -1) {
+    g_errors++;
+  }
+  run("PI");
+
+  printf("--- sample26.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
@@ -0,0 +1,247 @@
+/*
+  sample28.c - SFS Event Flag Group Demo
+
+  This sample demonstrates:
+    - Tasks waiting on an SFS_flags group with SFS_waitAny() and
+      SFS_waitAll() instead of polling a global: while they wait they
+      are off the queues and SFS_dispatch() does not count them.
+    - SFS_setFlags() from a task making a later task ready in the same
+      pass, and from outside a pass.
+    - Wait-all needing every flag, flags staying set until cleared, and
+      a wait already met returning at once.
+    - SFS_postFlags() from a simulated interrupt handler through a
+      request queue.
+    - A waiting task being suspended or killed, and 32 tasks each
+      waiting on its own flag, one made ready per flag set.
+    - A second wait in the same run replacing the first: met, the task
+      stays scheduled; not met, only the second group wakes it.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "sfs.h"
+
+#define MAX_TRACE 8
+#define EV_RX 0x01UL
+#define EV_TX 0x02UL
+#define EV_CFG 0x04UL
+#define EV_LINK 0x08UL
+#define EV_KICK 0x10UL
+#define WAITERS 32
+
+static SFS_flags g_events;
+static SFS_flags g_many;
+static SFS_flags g_a;
+static SFS_flags g_b;
+static SFS_cmd g_slot[4];
+static SFS_queue g_queue;
+static char g_trace[MAX_TRACE];
+static int g_traced = 0;
+static int g_pass = 0;
+static int g_woken[WAITERS];
+static int g_errors = 0;
+static SFS_ctx g_ctx;
+
+static void trace(char c)
+{
+  if (g_traced < MAX_TRACE - 1) {
+    g_trace[g_traced++] = c;
+  }
+}
+
+/* Sets EV_RX on pass 2 */
+void setter_task(void)
+{
+  trace('S');
+  if (g_pass == 2 && SFS_setFlags(&g_events, EV_RX) != 1) {
+    g_errors++;
+  }
+}
+
+/* Handles RX or TX, whichever comes */
+void any_task(void)
+{
+  unsigned long got = SFS_waitAny(&g_events, EV_RX | EV_TX);
+
+  if (!got) {
+    return;
+  }
+  SFS_clearFlags(&g_events, got);
+  trace(got == (EV_RX | EV_TX) ? 'B' : got == EV_RX ? 'R' : 'T');
+}
+
+/* Starts once configured and linked; the flags stay set */
+void all_task(void)
+{
+  if (!SFS_waitAll(&g_events, EV_CFG | EV_LINK)) {
+    return;
+  }
+  trace('L');
+}
+
+/* Waits for a kick from the "interrupt" */
+void kick_task(void)
+{
+  if (!SFS_waitAny(&g_events, EV_KICK)) {
+    return;
+  }
+  SFS_clearFlags(&g_events, EV_KICK);
+  trace('K');
+}
+
+/* Waits on A, then on B instead */
+void two_task(void)
+{
+  if (SFS_waitAny(&g_a, 0x01UL)) {
+    trace('a');
+    return;
+  }
+  if (SFS_waitAny(&g_b, 0x01UL)) {
+    trace('b');
+  }
+}
+
+void many_task(void *arg)
+{
+  int id = *(int *)arg;
+
+  if (!SFS_ctxWaitAny(&g_ctx, &g_many, 1UL << id)) {
+    return;
+  }
+  SFS_clearFlags(&g_many, 1UL << id);
+  g_woken[id]++;
+}
+
+static short run(const char *expect)
+{
+  short ret;
+
+  g_traced = 0;
+  ret = SFS_dispatch();
+  g_trace[g_traced] = '\0';
+  printf("pass %d: %-6s (%d ready)", g_pass, g_trace, ret);
+  if (strcmp(g_trace, expect) != 0) {
+    printf(" ERROR: expected %s", expect);
+    g_errors++;
+  }
+  printf("\n");
+  g_pass++;
+  return ret;
+}
+
+int main(void)
+{
+  static struct SFS_tg pool[WAITERS];
+  static SFS_ARENA(arena, WAITERS, SFS_WORK_SIZE);
+  static int ids[WAITERS];
+  char name[SFS_NAME_SIZE];
+  int i, woken;
+
+  printf("--- Event Flag Group Test ---\n");
+
+  SFS_initialize();
+  SFS_flagsInit(&g_events, 0);
+  SFS_queueInit(&g_queue, g_slot, 4, NULL, NULL);
+  SFS_listen(&g_queue);
+  SFS_fork("SETTER", 0, setter_task);
+  SFS_fork("ANY", 1, any_task);
+  SFS_fork("ALL", 2, all_task);
+  SFS_fork("KICK", 3, kick_task);
+
+  /* 1. Each waiter runs once to declare its wait, then costs nothing */
+  run("S");
+  if (run("S") != 1) {
+    printf("ERROR: waiting tasks were counted.\n");
+    g_errors++;
+  }
+  if (SFS_setFlags(&g_events, 0x100) != 0) {   /* nobody waits on it */
+    g_errors++;
+  }
+
+  /* 2. SETTER sets RX; ANY, behind it, handles it in the same pass */
+  run("SR");
+  run("S");
+
+  /* 3. Both at once, set from outside a pass */
+  SFS_setFlags(&g_events, EV_TX | EV_RX);
+  run("SB");
+
+  /* 4. Wait-all: CFG alone is not enough; the flags stay set, so ALL
+        runs every pass until they are cleared */
+  SFS_setFlags(&g_events, EV_CFG);
+  run("S");
+  SFS_setFlags(&g_events, EV_LINK);
+  run("SL");
+  run("SL");
+  SFS_clearFlags(&g_events, EV_CFG);
+  run("S");     /* LINK alone: ALL finds its wait unmet and waits again */
+  run("S");
+
+  /* 5. From an "interrupt", through the request queue */
+  SFS_postFlags(&g_queue, &g_events, EV_KICK);
+  run("SK");
+
+  /* 6. A suspended waiter stays off until resumed; a killed one leaves
+        the waiters */
+  SFS_suspend("ANY");
+  SFS_setFlags(&g_events, EV_TX);
+  run("S");
+  SFS_resume("ANY");
+  run("ST");
+  SFS_killByName("KICK");
+  if (SFS_setFlags(&g_events, EV_KICK) != 0) {
+    printf("ERROR: a killed task was still waiting.\n");
+    g_errors++;
+  }
+  run("S");
+
+  /* 7. Two waits in one run: the second one counts */
+  SFS_flagsInit(&g_a, 0);
+  SFS_flagsInit(&g_b, 0x01UL);
+  SFS_fork("TWO", 4, two_task);
+  run("Sb");
+  run("Sb");    /* B met: still scheduled, not left waiting on A */
+  SFS_clearFlags(&g_b, 0x01UL);
+  run("S");
+  if (SFS_setFlags(&g_a, 0x01UL) != 0) {
+    printf("ERROR: A woke a task waiting on B.\n");
+    g_errors++;
+  }
+  SFS_clearFlags(&g_a, 0x01UL);
+  if (SFS_setFlags(&g_b, 0x01UL) != 1) {
+    printf("ERROR: B did not wake TWO.\n");
+    g_errors++;
+  }
+  run("Sb");
+  SFS_killByName("TWO");
+
+  /* 8. 32 waiters on one group, each on its own flag */
+  SFS_ctxInitialize(&g_ctx, pool, WAITERS);
+  SFS_ctxArena(&g_ctx, arena, sizeof(arena));
+  SFS_flagsInit(&g_many, 0);
+  for (i = 0; i < WAITERS; i++) {
+    ids[i] = i;
+    sprintf(name, "W%d", i);
+    SFS_ctxForkArg(&g_ctx, name, (short)i, many_task, &ids[i]);
+  }
+  SFS_ctxDispatch(&g_ctx);
+  for (i = 0; i < WAITERS; i += 3) {
+    if (SFS_ctxSetFlags(&g_ctx, &g_many, 1UL << i) != 1) {
+      g_errors++;
+    }
+  }
+  woken = SFS_ctxDispatch(&g_ctx);
+  printf("%d waiters, %d made ready\n", WAITERS, woken);
+  for (i = 0; i < WAITERS; i++) {
+    if (g_woken[i] != (i % 3 == 0)) {
+      printf("ERROR: W%d ran %d times.\n", i, g_woken[i]);
+      g_errors++;
+    }
+  }
+  if (woken != (WAITERS + 2) / 3) {
+    g_errors++;
+  }
+
+  printf("--- sample28.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
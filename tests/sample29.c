@@ -0,0 +1,229 @@
+/*
+  sample29.c - SFS Adaptive Polling Demo
+
+  This sample demonstrates:
+    - A poller reporting SFS_IDLE with SFS_report() and sitting out
+      1, 3, 7, ... passes while it finds nothing to do, the other tasks
+      running every pass as before.
+    - SFS_wake() bringing a backed-off poller back early, and
+      SFS_BUSY keeping it on every pass while it has work.
+    - Backed-off tasks still counted by SFS_dispatch(), a suspended one
+      staying off once its back-off is over, and killing one.
+    - 100 pollers that are almost always idle on another instance: the
+      back-off levelling off at SFS_BACKOFF_MAX passes, and the calls
+      saved over 1000 passes.
+    - With a timer and an idle hook, a lone backed-off poller: the hook
+      is told the passes it sits out as ticks, 1, 3, 7, ..., instead of
+      0, and the ticks slept count as those passes.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "sfs.h"
+
+#define MAX_TRACE 8
+#define POLLERS 100
+#define PASSES 1000
+
+static char g_trace[MAX_TRACE];
+static int g_traced = 0;
+static int g_pass = 0;
+static int g_data = 0;
+static int g_errors = 0;
+
+static SFS_ctx g_ctx;
+static struct SFS_tg g_pool[POLLERS];
+static SFS_ARENA(g_arena, POLLERS, SFS_WORK_SIZE);
+static int g_mtPass = 0;
+static long g_calls = 0;
+static int g_ran[PASSES];
+static unsigned long g_clock = 0;
+static unsigned long g_slept[8];
+static int g_idled = 0;
+
+static void trace(char c)
+{
+  if (g_traced < MAX_TRACE - 1) {
+    g_trace[g_traced++] = c;
+  }
+}
+
+void a_task(void) { trace('A'); }
+void b_task(void) { trace('B'); }
+
+/* Busy while there is data, idle otherwise */
+void poll_task(void)
+{
+  if (!g_data) {
+    trace('p');
+    SFS_report(SFS_IDLE);
+    return;
+  }
+  g_data--;
+  trace('P');
+  SFS_report(SFS_BUSY);
+}
+
+/* Finds work on one pass in a hundred; poller 0 logs its runs */
+void idle_poller(void *arg)
+{
+  int id = *(int *)arg;
+
+  g_calls++;
+  if (id == 0) {
+    g_ran[g_mtPass] = 1;
+  }
+  SFS_ctxReport(&g_ctx, (g_mtPass + id) % 100 == 0 && g_mtPass >= 500 ? SFS_BUSY : SFS_IDLE);
+}
+
+void lone_poller(void)
+{
+  g_calls++;
+  SFS_ctxReport(&g_ctx, SFS_IDLE);
+}
+
+static unsigned long clock_ticks(void)
+{
+  return g_clock;
+}
+
+/* Sleeps by moving the clock */
+static void idle_hook(unsigned long ticks)
+{
+  if (g_idled < 8) {
+    g_slept[g_idled++] = ticks;
+  }
+  if (ticks != SFS_FOREVER) {
+    g_clock += ticks;
+  }
+}
+
+static void run(const char *expect, short count)
+{
+  short ret;
+
+  g_traced = 0;
+  ret = SFS_dispatch();
+  g_trace[g_traced] = '\0';
+  printf("pass %2d: %-6s (%d)", g_pass, g_trace, ret);
+  if (strcmp(g_trace, expect) != 0 || ret != count) {
+    printf(" ERROR: expected %s (%d)", expect, count);
+    g_errors++;
+  }
+  printf("\n");
+  g_pass++;
+}
+
+int main(void)
+{
+  static int ids[POLLERS];
+  char name[SFS_NAME_SIZE];
+  int i, last, gap, expect;
+
+  printf("--- Adaptive Polling Test ---\n");
+
+  SFS_initialize();
+  SFS_fork("A", 0, a_task);
+  SFS_fork("P", 1, poll_task);
+  SFS_fork("B", 2, b_task);
+  if (SFS_report(SFS_IDLE) != -1) {
+    printf("ERROR: a report outside a task was taken.\n");
+    g_errors++;
+  }
+
+  /* 1. Idle: P runs on passes 0, 2, 6, 14, and counts as a sleeping
+        task does while it sits out the others */
+  run("ApB", 4);
+  run("AB", 3);
+  run("ApB", 4);
+  for (i = 3; i < 6; i++) {
+    run("AB", 3);
+  }
+  run("ApB", 4);
+  run("AB", 3);
+
+  /* 2. Woken early; busy while data is left, then backing off again */
+  g_data = 2;
+  SFS_wake(SFS_lookup("P"));
+  run("APB", 3);
+  run("APB", 3);
+  run("ApB", 4);
+  run("AB", 3);
+  run("ApB", 4);
+
+  /* 3. Suspended while backed off, it stays off until resumed */
+  SFS_suspend("P");
+  for (i = 0; i < 5; i++) {
+    run("AB", 2);
+  }
+  SFS_resume("P");
+  run("ApB", 4);
+
+  /* 4. Killed while backed off */
+  SFS_killByName("P");
+  run("AB", 2);
+  run("AB", 2);
+
+  /* 5. 100 pollers, idle for 500 passes, then busy one pass in 100 */
+  SFS_ctxInitialize(&g_ctx, g_pool, POLLERS);
+  SFS_ctxArena(&g_ctx, g_arena, sizeof(g_arena));
+  for (i = 0; i < POLLERS; i++) {
+    ids[i] = i;
+    sprintf(name, "Q%d", i);
+    SFS_ctxForkArg(&g_ctx, name, 0, idle_poller, &ids[i]);
+  }
+  for (g_mtPass = 0; g_mtPass < PASSES; g_mtPass++) {
+    SFS_ctxDispatch(&g_ctx);
+  }
+  printf("%d pollers, %d passes: %ld calls instead of %d\n",
+         POLLERS, PASSES, g_calls, POLLERS * PASSES);
+  if (g_calls * 10 > (long)POLLERS * PASSES) {
+    g_errors++;
+  }
+
+  /* poller 0 backs off 2, 4, ... SFS_BACKOFF_MAX passes, never more */
+  expect = 2;
+  for (last = 0, i = 1; i < 500; i++) {
+    if (!g_ran[i]) {
+      continue;
+    }
+    gap = i - last;
+    if (gap != expect) {
+      printf("ERROR: ran %d passes after the last run, expected %d.\n", gap, expect);
+      g_errors++;
+    }
+    expect = gap < SFS_BACKOFF_MAX ? gap * 2 : SFS_BACKOFF_MAX;
+    last = i;
+  }
+  if (expect != SFS_BACKOFF_MAX) {
+    g_errors++;
+  }
+
+  /* 6. Tickless idle while backed off: the hook sleeps the passes the
+        poller sits out, and it runs on every dispatch */
+  SFS_ctxInitialize(&g_ctx, g_pool, POLLERS);
+  SFS_ctxArena(&g_ctx, g_arena, sizeof(g_arena));
+  SFS_ctxTimer(&g_ctx, clock_ticks);
+  SFS_ctxIdle(&g_ctx, idle_hook);
+  SFS_ctxFork(&g_ctx, "LONE", 0, lone_poller);
+  g_calls = 0;
+  for (i = 0; i < 8; i++) {
+    SFS_ctxDispatch(&g_ctx);
+  }
+  printf("idle hook:");
+  for (i = 0, expect = 1; i < g_idled; i++) {
+    printf(" %lu", g_slept[i]);
+    if (g_slept[i] != (unsigned long)expect) {
+      g_errors++;
+    }
+    expect = expect * 2 + 1 < SFS_BACKOFF_MAX ? expect * 2 + 1 : SFS_BACKOFF_MAX - 1;
+  }
+  printf(" ticks, %ld runs in 8 dispatches, clock %lu\n", g_calls, g_clock);
+  if (g_idled != 7 || g_calls != 8) {
+    printf("ERROR: the poller was not run after its back-off.\n");
+    g_errors++;
+  }
+
+  printf("--- sample29.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
@@ -0,0 +1,219 @@
+/*
+  sample31.c - SFS Linux Hosted Port Demo
+
+  This sample demonstrates:
+    - gFreeRunCounter kept in step with CLOCK_MONOTONIC by the port
+      (libs/linux) instead of a usleep() thread, with a one-shot
+      timerfd waking the process only when a periodic task is due.
+    - Tasks waiting on file descriptors with SFS_linuxWait(): a pipe
+      for reading and a socket for writing, run only once epoll
+      reports them.
+    - The idle hook sleeping in a single epoll_wait() until another
+      thread writes to the pipe, with no timer wakeups or passes in
+      between.
+    - One task waiting on two descriptors in turn in the same run,
+      staying scheduled when the second one is ready.
+    - GetFreeRunCounter() through the port's _di/_ei, and the errors
+      of a second port, a bad descriptor and a double unwatch.
+*/
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include "frcc.h"
+#include "sfs_linux.h"
+
+#define TICK_US 1000
+#define BLINKS 5
+
+static SFS_ctx g_ctx;
+static struct SFS_tg g_pool[4];
+static SFS_ARENA(g_arena, 4, SFS_WORK_SIZE);
+static SFS_linux g_port;
+
+static int g_pipe[2];
+static int g_sock[2];
+static int g_quiet[2];
+static short g_rx, g_tx, g_qx;
+static int g_echoed = 0;
+static int g_echoes = 0;
+static int g_sent = 0;
+static int g_blinks = 0;
+static int g_writable = 0;
+static int g_errors = 0;
+
+/* Reads whatever the pipe holds once it is readable */
+void echo_task(void)
+{
+  char buf[16];
+  ssize_t n;
+
+  if (!(SFS_linuxWait(&g_port, g_rx) & SFS_LINUX_READ)) {
+    return;
+  }
+  n = read(g_pipe[0], buf, sizeof(buf));
+  if (n > 0) {
+    g_echoed += (int)n;
+  }
+  g_echoes++;
+}
+
+/* Sends once the socket is writable, then ends */
+void send_task(void)
+{
+  if (!(SFS_linuxWait(&g_port, g_tx) & SFS_LINUX_WRITE)) {
+    return;
+  }
+  if (write(g_sock[0], "ping", 4) == 4) {
+    g_sent++;
+  }
+  SFS_ctxKill(&g_ctx);
+}
+
+/* Waits on a pipe nobody writes to, then on the socket instead */
+void duplex_task(void)
+{
+  if (SFS_linuxWait(&g_port, g_qx)) {
+    g_errors++;
+    return;
+  }
+  if (SFS_linuxWait(&g_port, g_tx) & SFS_LINUX_WRITE) {
+    g_writable++;
+  }
+}
+
+void blink_task(void)
+{
+  g_blinks++;
+}
+
+/* Another thread writing to the pipe 30ms from now */
+static void *late_writer(void *arg)
+{
+  struct timespec ts;
+
+  ts.tv_sec = 0;
+  ts.tv_nsec = 30 * 1000000L;
+  nanosleep(&ts, NULL);
+  if (write(g_pipe[1], "late", 4) != 4) {
+    g_errors++;
+  }
+
+  return arg;
+}
+
+static long now_ms(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long)ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+static void check(int ok, const char *what)
+{
+  if (!ok) {
+    printf("ERROR: %s\n", what);
+    g_errors++;
+  }
+}
+
+int main(void)
+{
+  static SFS_linux other;
+  pthread_t tid;
+  char buf[8];
+  unsigned long start, blocks;
+  long wall;
+  int passes;
+
+  printf("--- Linux Hosted Port Test ---\n");
+
+  SFS_ctxInitialize(&g_ctx, g_pool, 4);
+  SFS_ctxArena(&g_ctx, g_arena, sizeof(g_arena));
+  if (pipe(g_pipe) != 0 || pipe(g_quiet) != 0 ||
+      socketpair(AF_UNIX, SOCK_STREAM, 0, g_sock) != 0 ||
+      SFS_linuxInitialize(&g_port, &g_ctx, TICK_US) != 0) {
+    printf("ERROR: no port.\n");
+    return 1;
+  }
+  check(SFS_linuxInitialize(&other, &g_ctx, TICK_US) == -1, "a second port was started.");
+  check(SFS_linuxWatch(&g_port, -1, SFS_LINUX_READ) == -1, "a bad descriptor was watched.");
+  g_rx = SFS_linuxWatch(&g_port, g_pipe[0], SFS_LINUX_READ);
+  g_tx = SFS_linuxWatch(&g_port, g_sock[0], SFS_LINUX_WRITE);
+  SFS_ctxFork(&g_ctx, "ECHO", 0, echo_task);
+  SFS_ctxFork(&g_ctx, "SEND", 1, send_task);
+
+  /* 1. Both wait; the socket is writable at once, the pipe is empty */
+  SFS_linuxDispatch(&g_port);
+  check(g_sent == 0 && g_echoes == 0, "a task ran before its descriptor was ready.");
+  SFS_linuxDispatch(&g_port);
+  check(g_sent == 1 && read(g_sock[1], buf, 4) == 4 && memcmp(buf, "ping", 4) == 0,
+        "SEND did not send once writable.");
+
+  /* 2. Written from here: the idle hook finds it, ECHO runs */
+  check(write(g_pipe[1], "abc", 3) == 3, "write to the pipe.");
+  SFS_linuxDispatch(&g_port);
+  printf("echoed %d bytes in %d runs\n", g_echoed, g_echoes);
+  check(g_echoes == 1 && g_echoed == 3, "ECHO did not read the pipe once.");
+
+  /* 3. Nothing ready and nothing timed: sleeps in epoll_wait() until
+        the other thread writes */
+  pthread_create(&tid, NULL, late_writer, NULL);
+  start = GetFreeRunCounter();
+  blocks = g_port.blocks;
+  for (passes = 0; g_echoes < 2 && passes < 100; passes++) {
+    SFS_linuxDispatch(&g_port);
+  }
+  pthread_join(tid, NULL);
+  printf("woken after %lu ticks, %d passes, %lu blocking waits\n",
+         GetFreeRunCounter() - start, passes, g_port.blocks - blocks);
+  check(g_echoes == 2 && g_echoed == 7, "ECHO was not woken by the write.");
+  check(passes <= 2, "passes were run while waiting.");
+  check(g_port.blocks - blocks <= 2, "the idle process was woken by the timer.");
+  check(GetFreeRunCounter() - start >= 20, "woken before the write.");
+
+  /* 4. A periodic task every 10 ticks: the counter follows the clock,
+        within a loose bound for a loaded host */
+  SFS_ctxForkPeriodic(&g_ctx, "BLINK", 2, blink_task, 10);
+  start = GetFreeRunCounter();
+  blocks = g_port.blocks;
+  wall = now_ms();
+  for (passes = 0; g_blinks < BLINKS && passes < 1000; passes++) {
+    SFS_linuxDispatch(&g_port);
+  }
+  wall = now_ms() - wall;
+  printf("%d blinks: %lu ticks, %ld ms, %d passes, %lu blocking waits\n",
+         g_blinks, GetFreeRunCounter() - start, wall, passes, g_port.blocks - blocks);
+  check(g_blinks == BLINKS, "BLINK did not run.");
+  check(GetFreeRunCounter() - start >= (BLINKS - 1) * 10, "BLINK ran early.");
+  check((long)(GetFreeRunCounter() - start) <= wall + 10 &&
+        (long)(GetFreeRunCounter() - start) + 10 >= wall, "the counter drifted from the clock.");
+  check(g_port.blocks - blocks <= 2 * BLINKS, "the timer woke the process between blinks.");
+  check(passes <= 3 * BLINKS, "passes were run between blinks.");
+  check(GetFreeRunCounter() == gFreeRunCounter, "GetFreeRunCounter().");
+
+  /* 5. Two waits in one run on the same port: the second one counts */
+  g_qx = SFS_linuxWatch(&g_port, g_quiet[0], SFS_LINUX_READ);
+  SFS_ctxFork(&g_ctx, "DUPLEX", 3, duplex_task);
+  for (passes = 0; passes < 8; passes++) {
+    SFS_linuxDispatch(&g_port);
+  }
+  printf("DUPLEX found the socket writable %d times in 8 passes\n", g_writable);
+  check(g_writable >= 3, "DUPLEX was left waiting on the quiet pipe.");
+  SFS_ctxKillByName(&g_ctx, "DUPLEX");
+
+  /* 6. Unwatching */
+  check(SFS_linuxUnwatch(&g_port, g_rx) == 0, "unwatch.");
+  check(SFS_linuxUnwatch(&g_port, g_rx) == -1, "a slot was unwatched twice.");
+  SFS_linuxShutdown(&g_port);
+  check(SFS_linuxInitialize(&other, &g_ctx, TICK_US) == 0, "a port after shutdown.");
+  SFS_linuxShutdown(&other);
+
+  printf("--- sample31.c test %s. ---\n", g_errors ? "FAILED" : "finished successfully");
+
+  return g_errors ? 1 : 0;
+}
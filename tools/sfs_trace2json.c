@@ -0,0 +1,112 @@
+/*
+  sfs_trace2json.c - SFS_TRACE dump to Chrome trace JSON
+
+  Host-side tool; unlike the library it uses the C standard library.
+
+    sfs_trace2json dump.sfst [ticks_per_us] > trace.json
+
+  Open the output in chrome://tracing or ui.perfetto.dev.  Dispatch
+  records become complete ("X") slices, fork/kill/change records
+  instant ("i") events.  Timestamps are the trace clock divided by
+  ticks_per_us (default 1).
+
+  Dump layout, native byte order, as written next to the target:
+    "SFST"
+    unsigned long records
+    unsigned long names
+    SFS_event     record[records]         oldest first (SFS_traceRead)
+    char          name[names][SFS_NAME_SIZE]   by TCB index (SFS_traceName)
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define SFS_TRACE
+#include "sfs.h"
+
+static const char *const g_type[] = { "dispatch", "fork", "kill", "change" };
+
+static void put_name(const char *name)
+{
+  for (; *name; name++) {
+    if (*name == '"' || *name == '\\') {
+      putchar('\\');
+    }
+    putchar(*name);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  FILE *fp;
+  char magic[4];
+  unsigned long records, names, i;
+  char (*name)[SFS_NAME_SIZE];
+  SFS_event ev;
+  double scale = 1.0;
+  const char *task;
+  char unknown[32];
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s dump.sfst [ticks_per_us]\n", argv[0]);
+    return 2;
+  }
+  if (argc > 2) {
+    scale = atof(argv[2]);
+    if (scale <= 0.0) {
+      scale = 1.0;
+    }
+  }
+  fp = fopen(argv[1], "rb");
+  if (fp == NULL) {
+    perror(argv[1]);
+    return 1;
+  }
+  if (fread(magic, 1, 4, fp) != 4 || memcmp(magic, "SFST", 4) != 0 ||
+      fread(&records, sizeof(records), 1, fp) != 1 || fread(&names, sizeof(names), 1, fp) != 1) {
+    fprintf(stderr, "%s: not an SFS trace dump\n", argv[1]);
+    fclose(fp);
+    return 1;
+  }
+
+  /* the name table follows the records */
+  name = malloc(names ? names * SFS_NAME_SIZE : 1);
+  if (name == NULL ||
+      fseek(fp, (long)(records * sizeof(SFS_event)), SEEK_CUR) != 0 ||
+      fread(name, SFS_NAME_SIZE, names, fp) != names) {
+    fprintf(stderr, "%s: truncated dump\n", argv[1]);
+    fclose(fp);
+    return 1;
+  }
+  fseek(fp, 4 + 2 * (long)sizeof(unsigned long), SEEK_SET);
+
+  printf("{\"traceEvents\":[\n");
+  printf("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"SFS\"}}");
+  for (i = 0; i < records && fread(&ev, sizeof(ev), 1, fp) == 1; i++) {
+    if (ev.task < names) {
+      name[ev.task][SFS_NAME_SIZE - 1] = '\0';
+      task = name[ev.task];
+    } else {
+      sprintf(unknown, "task %u", ev.task);
+      task = unknown;
+    }
+    printf(",\n{\"name\":\"");
+    if (ev.type != SFS_EV_DISPATCH) {
+      printf("%s ", ev.type <= SFS_EV_CHANGE ? g_type[ev.type] : "event");
+    }
+    put_name(task);
+    printf("\",\"cat\":\"%s\",", ev.type <= SFS_EV_CHANGE ? g_type[ev.type] : "event");
+    if (ev.type == SFS_EV_DISPATCH) {
+      printf("\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,", ev.start / scale, (ev.end - ev.start) / scale);
+    } else {
+      printf("\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,", ev.start / scale);
+    }
+    printf("\"pid\":1,\"tid\":1,\"args\":{\"task\":%u}}", ev.task);
+  }
+  printf("\n]}\n");
+
+  free(name);
+  fclose(fp);
+  fprintf(stderr, "%lu of %lu records converted.\n", i, records);
+
+  return i == records ? 0 : 1;
+}